@@ -2,84 +2,141 @@
 
 #include<stdio.h>
 #include<stdlib.h>
+#include<stdint.h>
 
-typedef struct no_ NO;
+#define GRAFO_LIMIAR_HASH 8   //a partir deste grau as buscas passam pelo hash
 
-struct no_{
-   NO *proximo;
+typedef struct aresta_ ARESTA;
+
+struct aresta_{
    int chave;
    int peso;
 };
 
-/*Estrutura de controle*/
+/*
+Estrutura de controle: as ligações ficam num vetor na ordem de inserção
+(busca linear enquanto o grau é pequeno). Quando o grau chega a
+GRAFO_LIMIAR_HASH, `indice` passa a guardar, por endereçamento aberto com
+sondagem linear, a posição + 1 (0 = vazio) da primeira ligação de cada
+chave, com ocupação de no máximo metade.
+*/
 struct grafo_{
-   NO *inicio;
-   NO *fim;
+   ARESTA *arestas;
    int tamanho;
+   int capacidade;
+   int *indice;
+   int indice_cap;   //potência de 2, ou 0 sem hash
 };
 
+static unsigned espalhar(int chave, int cap){
+   return ((uint32_t) chave * 0x9E3779B1u) & (uint32_t)(cap - 1);
+}
+
+//posição da primeira ligação com a chave, ou -1
+static int procurar(GRAFO *grafo, int chave){
+   if(grafo->indice != NULL){
+      for(unsigned h = espalhar(chave, grafo->indice_cap); grafo->indice[h] != 0; h = (h + 1) & (grafo->indice_cap - 1)){
+         if(grafo->arestas[grafo->indice[h] - 1].chave == chave) return grafo->indice[h] - 1;
+      }
+      return -1;
+   }
+
+   for(int i = 0; i < grafo->tamanho; i++){
+      if(grafo->arestas[i].chave == chave) return i;
+   }
+   return -1;
+}
+
+//coloca a posição no hash, se a chave ainda não estiver lá (vale a primeira)
+static void indexar(GRAFO *grafo, int posicao){
+   int chave = grafo->arestas[posicao].chave;
+   unsigned h = espalhar(chave, grafo->indice_cap);
+
+   for(; grafo->indice[h] != 0; h = (h + 1) & (grafo->indice_cap - 1)){
+      if(grafo->arestas[grafo->indice[h] - 1].chave == chave) return;
+   }
+   grafo->indice[h] = posicao + 1;
+}
+
+//refaz o hash com espaço para pelo menos o dobro de `tamanho` chaves
+static bool reindexar(GRAFO *grafo, int tamanho){
+   int cap = 16;
+   while(cap < 2 * tamanho) cap *= 2;
+
+   int *indice = (int*) calloc(cap, sizeof(int));
+   if(indice == NULL) return false;
+
+   free(grafo->indice);
+   grafo->indice = indice;
+   grafo->indice_cap = cap;
+   for(int i = 0; i < grafo->tamanho; i++) indexar(grafo, i);
+   return true;
+}
 
 GRAFO *grafo_criar(){
    GRAFO *grafo = (GRAFO*) malloc(sizeof(GRAFO));
-   
+
    if(grafo != NULL){
-      grafo->inicio = NULL;   
-      grafo->fim = NULL;
-      grafo->tamanho = 0; 
+      grafo->arestas = NULL;
+      grafo->tamanho = 0;
+      grafo->capacidade = 0;
+      grafo->indice = NULL;
+      grafo->indice_cap = 0;
    }
 
    return(grafo);
 }
 
 bool grafo_inserir(GRAFO *grafo, int chave, int peso){
-   if(!grafo_cheia(grafo)){
-      NO *no = (NO*) malloc(sizeof(NO));
-      if(no == NULL) return false;
-      no->chave = chave;
-      no->peso = peso;
+   if(grafo == NULL) return false;
 
-      no->proximo = NULL;
+   if(grafo->tamanho == grafo->capacidade){
+      int capacidade = grafo->capacidade == 0 ? 4 : 2 * grafo->capacidade;
+      ARESTA *arestas = (ARESTA*) realloc(grafo->arestas, capacidade * sizeof(ARESTA));
+      if(arestas == NULL) return false;
 
-      if(grafo->inicio == NULL){
-         grafo->inicio = no;
-         grafo->fim = no;
-      }
-      else{
-         grafo->fim->proximo = no;
-         grafo->fim = no;   
-      }
-      grafo->tamanho++;
-      
-      return true;
+      grafo->arestas = arestas;
+      grafo->capacidade = capacidade;
+   }
+
+   //o hash nasce ou cresce antes de a nova ligação entrar no vetor
+   if(grafo->tamanho + 1 >= GRAFO_LIMIAR_HASH && 2 * (grafo->tamanho + 1) > grafo->indice_cap){
+      if(!reindexar(grafo, grafo->tamanho + 1)) return false;
    }
-   return false;
+
+   grafo->arestas[grafo->tamanho].chave = chave;
+   grafo->arestas[grafo->tamanho].peso = peso;
+   grafo->tamanho++;
+
+   if(grafo->indice != NULL) indexar(grafo, grafo->tamanho - 1);
+   return true;
+}
+
+bool grafo_inserir_ou_atualizar(GRAFO *grafo, int chave, int peso){
+   if(grafo == NULL) return false;
+
+   int posicao = procurar(grafo, chave);
+   if(posicao == -1) return grafo_inserir(grafo, chave, peso);
+
+   grafo->arestas[posicao].peso = peso;
+   return true;
 }
 
 bool grafo_apagar(GRAFO **grafo){
-   if(!grafo_vazia(*grafo)){
-      while((*grafo)->inicio != NULL){
-         // Tirar no do grafo, deixando-a encadeada.
-         NO *no_apagado = (*grafo)->inicio;
-         (*grafo)->inicio = (*grafo)->inicio->proximo;
-         
-         // Apagar no.
-         no_apagado->proximo = NULL; 
-         free(no_apagado); no_apagado = NULL;
-      }
-      (*grafo)->fim = NULL;
-      free(*grafo); *grafo = NULL; 
-      return true;
-   }
-   return false;
+   if(grafo == NULL || *grafo == NULL) return false;
+
+   bool tinha = !grafo_vazia(*grafo);
+
+   free((*grafo)->arestas);
+   free((*grafo)->indice);
+   free(*grafo); *grafo = NULL;
+   return tinha;
 }
 
 int grafo_busca(GRAFO *grafo, int chave){
    if(!grafo_vazia(grafo)){
-      NO *busca = grafo->inicio;
-      while(busca != NULL){
-         if(chave == busca->chave) return(busca->peso);
-         busca = busca->proximo;
-      }
+      int posicao = procurar(grafo, chave);
+      if(posicao != -1) return(grafo->arestas[posicao].peso);
    }
    return(-1); // Não há ligação
 }
@@ -93,18 +150,19 @@ int grafo_tamanho(GRAFO *grafo){
 
 bool grafo_vazia(GRAFO *grafo){
    if(grafo != NULL){
-      return(grafo->inicio == NULL);
+      return(grafo->tamanho == 0);
    }
    return true;
 }
 
 bool grafo_cheia(GRAFO *grafo){
    if(grafo != NULL){
-      NO *no = (NO*) malloc(sizeof(NO));
+      if(grafo->tamanho < grafo->capacidade) return(false);
 
-      if(no == NULL) return(true);
-   
-      free(no); no = NULL;
+      ARESTA *teste = (ARESTA*) malloc((grafo->capacidade + 1) * sizeof(ARESTA));
+      if(teste == NULL) return(true);
+
+      free(teste); teste = NULL;
       return(false);
    }
    return(true);
@@ -124,112 +182,20 @@ GRAFO **alocar_vetor_grafo(int n){
 bool grafo_set_chave(GRAFO* grafo, int chave, int conteudo){
 
    if(!grafo_vazia(grafo)){
-      NO *busca = grafo->inicio;
-      while(busca != NULL){
-         if(chave == busca->chave){
-            busca->peso = conteudo;
-            return true;
-         }
-         busca = busca->proximo;
+      int posicao = procurar(grafo, chave);
+      if(posicao != -1){
+         grafo->arestas[posicao].peso = conteudo;
+         return true;
       }
    }
    return(false); // Não há ligação
 }
 
-void menor_caminho(GRAFO **distancia, int origem, int N){
-
-   int dp[(1<<N) + 2][N+2];
-   //dp[i][j]:
-   //estou na mask "i" e o ultimo que visitei foi o "j",
-   //guardo a menor distância até esse node i, passando por todos que estão ativos na minha mask;
+//Chama cb para cada ligação, na ordem de inserção
+void grafo_percorrer(GRAFO *grafo, void (*cb)(int chave, int peso, void *ctx), void *ctx){
+   if(grafo_vazia(grafo)) return;
 
-   for(int i = 0; i < (1<<N); i++){
-      for(int j = 0; j<N+1; j++){
-         //Inicializo minha dp com um valor alto,
-         //Para ser mudado na transição da minha dp
-         dp[i][j] = 1e9; 
-      }
+   for(int i = 0; i < grafo->tamanho; i++){
+      cb(grafo->arestas[i].chave, grafo->arestas[i].peso, ctx);
    }
-
-   dp[1<<origem][origem] = 0;
-   //O ultimo que visitei foi a origem, e só tenho a origem ligada na minha mask
-   //logo, a distância que guardo é ZERO
-
-   GRAFO **mapa = alocar_vetor_grafo(N+1); 
-   //mapa[filho][MASK] = pai 
-
-   for(int mask = 1; mask < (1<<N); mask++){ //passo por todas as mask
-      if((mask & (1<<origem)) == 0) continue; //a origem não está ativa -> dou continue
-        for(int pai = 0; pai < N; pai++){ //bruto nos pais que estão ligados na mask
-            if((mask & (1<<pai)) == 0) continue; //o pai nem está ativo nessa mask -> dou continue
-            for(int filho = 0; filho < N; filho++){ //passo por todos os nodes filhos dele
-
-               if(grafo_busca(distancia[pai], filho) == -1 || (mask & (1<<filho))!= 0) continue;
-               //não tenho ligação desse pai com esse filho OU já visitei esse filho -> Dou Continue 
-
-               if(dp[mask][pai] + grafo_busca(distancia[pai], filho) < dp[mask + (1<<filho)][filho]){ //Transição da minha dp
-                  dp[mask + (1<<filho)][filho] = dp[mask][pai] + grafo_busca(distancia[pai], filho); //atualizo minha dp se achei um cara melhor
-
-                  if(!grafo_set_chave(mapa[filho], mask+(1<<filho), pai)) grafo_inserir(mapa[filho], mask+(1<<filho), pai);
-                  //Se já setei essa pai, na localização (filho, bitmask) da minha matriz eu vou atualizar
-                  //Se ainda não setei, eu posso inserir direto na minha matriz
-               }
-            }
-         }
-   }
-
-   int resp = 1e9; 
-   int ultimo;
-
-   //achando a menor distância e o ultimo node que passei pelo meu caminho
-   for(int i = 0; i < N; i++){ 
-      if(grafo_busca(distancia[i], origem) != -1){ 
-         //tenho uma ligação de volta do ultimo que visitei com o primeiro para fechar o ciclo!
-         //vou passar por todos os nodes na mask (2^N - 1), em base 2 : (11...11)
-         //logo, representa o a mask que passei por todos os nodes!
-
-         if((dp[(1<<N)-1][i] + grafo_busca(distancia[i], origem)) < resp){
-            //Acho a menor distância nessa dp que tem todos os bits visitados
-            //lembrando que preciso acrescentar o peso da aresta do ultimo com
-            //o primeiro, pois no problema ele precisa voltar para a origem 
-
-            resp = dp[(1<<N)-1][i]+ grafo_busca(distancia[i], origem);
-
-            //guardo o ultimo visitado
-            ultimo = i;
-         } 
-      }
-   }
-   
-   
-
-   int eu = ultimo;
-   int mapa_now = (1<<N) - 1;
-
-   printf("Cidade de Origem: %d\n", origem+1);
-   printf("Rota: %d - %d",origem+1,  eu+1);
-
-   //função para printar meu menor caminho
-   while(1){
-      //a logica se basei em ir de baixo para cima, como guardamos no mapa
-      //quem é o melhor node para chegar em uma dada mask, para obter o menor caminho
-      //logo, basta ir quando a mask está toda preenchida e vê quem chega no node ultimo
-      //depois, basta apagar esse node que acabamos de encontrar na mask e olhar na posição
-      //de quem chega nesse ultimo, que é o que estavamos guardado na matriz anterior
-      //Esse ciclo de operações, vai retornar o caminho percorrido
-
-      if(grafo_busca(mapa[eu], mapa_now) == origem){
-         printf(" - %d\n", grafo_busca(mapa[eu], mapa_now) + 1);
-         break;
-      }
-
-      printf(" - %d", grafo_busca(mapa[eu], mapa_now) + 1);
-
-      int eu_suporte = eu;
-      eu = grafo_busca(mapa[eu], mapa_now);
-      mapa_now = (mapa_now - (1<<eu_suporte));
-
-   }
-   printf("Menor distancia: %d\n", resp);
 }
-
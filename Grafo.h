@@ -8,14 +8,18 @@
     typedef struct grafo_ GRAFO; 
 
     GRAFO *grafo_criar();
+    // Acrescenta a ligação sem procurar a chave; se ela se repetir, grafo_busca
+    // (com ou sem o hash) devolve o peso da primeira.
     bool grafo_inserir(GRAFO *grafo, int chave, int peso);
+    // Atualiza o peso da ligação com a chave, ou insere se ela não existe.
+    bool grafo_inserir_ou_atualizar(GRAFO *grafo, int chave, int peso);
     bool grafo_apagar(GRAFO **grafo);
     int grafo_busca(GRAFO *grafo, int chave);
     int grafo_tamanho(GRAFO *grafo);
     bool grafo_vazia(GRAFO *grafo);
     bool grafo_cheia(GRAFO *grafo);
-    void menor_caminho(GRAFO **distancia, int origem, int tamanho);
     GRAFO **alocar_vetor_grafo(int n);
     bool grafo_set_chave(GRAFO* grafo, int chave, int conteudo);
+    void grafo_percorrer(GRAFO *grafo, void (*cb)(int chave, int peso, void *ctx), void *ctx);
 
 #endif
\ No newline at end of file
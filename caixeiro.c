@@ -0,0 +1,758 @@
+#include "caixeiro.h"
+#include "viabilidade.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<inttypes.h>
+
+/*Buffers reaproveitados entre chamadas; `*_cap` é a capacidade em bytes*/
+struct caixeiro_area{
+   int *bruto;          //matriz int lida das listas de adjacência
+   size_t bruto_cap;
+   void *peso;          //matriz no tipo de custo escolhido
+   size_t peso_cap;
+   void *tabela;        //tabela da dp
+   size_t tabela_cap;
+   void *marca;         //visitados da heurística
+   size_t marca_cap;
+   void *cidade;        //renumeração sem a origem (layout em camadas)
+   size_t cidade_cap;
+   void *inicio;        //começo de cada camada
+   size_t inicio_cap;
+};
+
+CAIXEIRO_AREA *caixeiro_area_criar(void){
+   return (CAIXEIRO_AREA*) calloc(1, sizeof(CAIXEIRO_AREA));
+}
+
+void caixeiro_area_apagar(CAIXEIRO_AREA **area){
+   if(area == NULL || *area == NULL) return;
+
+   free((*area)->bruto);
+   free((*area)->peso);
+   free((*area)->tabela);
+   free((*area)->marca);
+   free((*area)->cidade);
+   free((*area)->inicio);
+   free(*area); *area = NULL;
+}
+
+/*
+Garante que *buffer tenha pelo menos `bytes`. Só realoca quando precisa
+crescer, então uma área reutilizada com instâncias do mesmo tamanho não
+aloca mais nada depois da primeira chamada.
+*/
+static void *reservar(void *buffer, size_t *cap, size_t bytes){
+   void **atual = (void**) buffer;
+
+   if(bytes <= *cap) return *atual;
+
+   void *novo = realloc(*atual, bytes);
+   if(novo == NULL) return NULL;
+
+   *atual = novo;
+   *cap = bytes;
+   return novo;
+}
+
+/*
+Largura (em bits) do menor tipo sem sinal que guarda com folga qualquer
+soma até `limite`. Numa rota são N arestas, logo peso_maximo * N limita a
+soma; largura_custo retorna 0 se houver peso negativo, que a dp não suporta.
+*/
+static int largura_limite(uint64_t limite){
+   if(limite < UINT16_MAX) return 16;
+   if(limite < UINT32_MAX) return 32;
+   return 64;
+}
+
+static int largura_custo(const int *peso, int N){
+   uint64_t peso_maximo = 0;
+
+   for(int i = 0; i < N * N; i++){
+      if(peso[i] == SEM_LIGACAO) continue;
+      if(peso[i] < 0) return 0;
+      if((uint64_t) peso[i] > peso_maximo) peso_maximo = (uint64_t) peso[i];
+   }
+
+   return largura_limite(peso_maximo * (uint64_t) N);
+}
+
+//indice do bit menos significativo ligado (x != 0)
+static int menor_bit(uint64_t x){
+#if defined(__GNUC__)
+   return __builtin_ctzll(x);
+#else
+   int i = 0;
+   while((x & 1) == 0){ x >>= 1; i++; }
+   return i;
+#endif
+}
+
+//mask sobre as cidades renumeradas sem a origem -> mask com os indices originais
+static uint64_t reinsere_origem(uint64_t mask, int origem){
+   uint64_t baixo = mask & (((uint64_t)1 << origem) - 1);
+   return baixo | ((mask >> origem) << (origem + 1));
+}
+
+#define CUSTO uint16_t
+#define CUSTO_MAX UINT16_MAX
+#define SUFIXO 16
+#include "caixeiro_dp.h"
+#undef CUSTO
+#undef CUSTO_MAX
+#undef SUFIXO
+
+#define CUSTO uint32_t
+#define CUSTO_MAX UINT32_MAX
+#define SUFIXO 32
+#include "caixeiro_dp.h"
+#undef CUSTO
+#undef CUSTO_MAX
+#undef SUFIXO
+
+#define CUSTO uint64_t
+#define CUSTO_MAX UINT64_MAX
+#define SUFIXO 64
+#include "caixeiro_dp.h"
+#undef CUSTO
+#undef CUSTO_MAX
+#undef SUFIXO
+
+
+/*
+Passa a matriz pelas verificações de viabilidade.h. Devolve uma cópia na
+área sem as arestas que nenhuma rota pode usar (as que as arestas forçadas
+eliminaram), ou NULL com *status = CAIXEIRO_SEM_ROTA se a instância é
+impossível, sem chegar a alocar a tabela da dp.
+*/
+static const int *matriz_viavel(CAIXEIRO_AREA *area, const int *peso, int N, CAIXEIRO_STATUS *status){
+   uint64_t vizinhos[CAIXEIRO_MAX_CIDADES];
+
+   for(int u = 0; u < N; u++){
+      vizinhos[u] = 0;
+      for(int v = 0; v < N; v++){
+         if(peso[u*N + v] != SEM_LIGACAO || peso[v*N + u] != SEM_LIGACAO) vizinhos[u] |= (uint64_t)1 << v;
+      }
+   }
+
+   if(!viabilidade_reduzir(vizinhos, N)){
+      *status = CAIXEIRO_SEM_ROTA;
+      return NULL;
+   }
+
+   //caixeiro_resolver já entrega a própria area->bruto; nesse caso a cópia é no lugar
+   int *viavel = (int*) reservar(&area->bruto, &area->bruto_cap, (size_t)N * N * sizeof(int));
+   if(viavel == NULL){
+      *status = CAIXEIRO_SEM_MEMORIA;
+      return NULL;
+   }
+
+   for(int u = 0; u < N; u++){
+      for(int v = 0; v < N; v++){
+         //com N < 3 nada é verificado e os laços ficam como estão
+         bool usada = u == v || (vizinhos[u] & ((uint64_t)1 << v)) != 0;
+         viavel[u*N + v] = usada ? peso[u*N + v] : SEM_LIGACAO;
+      }
+   }
+   return viavel;
+}
+
+/*
+Com distâncias simétricas uma rota e a inversa custam o mesmo, e cada
+motor desempata de um jeito. Fico sempre com a que sai da origem para a
+menor das duas vizinhas, para a resposta não depender do motor.
+*/
+static void orientar_rota(const int *peso, int N, int *rota){
+   if(N < 3 || rota[1] < rota[N-1]) return;
+
+   for(int u = 0; u < N; u++){
+      for(int v = 0; v < u; v++){
+         if(peso[u*N + v] != peso[v*N + u]) return;
+      }
+   }
+
+   for(int x = 1, y = N - 1; x < y; x++, y--){
+      int aux = rota[x]; rota[x] = rota[y]; rota[y] = aux;
+   }
+}
+
+CAIXEIRO_STATUS caixeiro_resolver_matriz(CAIXEIRO_AREA *area, const int *peso, int origem, int N,
+                                         int opcoes, CAIXEIRO_RESULTADO *resultado){
+   CAIXEIRO_STATUS status = CAIXEIRO_ENTRADA_INVALIDA;
+
+   resultado->custo = 0;
+   resultado->tamanho = 0;
+
+   if(area != NULL && peso != NULL && N > 0 && N <= CAIXEIRO_MAX_CIDADES && origem >= 0 && origem < N){
+      bool camadas = (opcoes & MC_CAMADAS) != 0;
+      bool meio = (opcoes & MC_MEIO) != 0;
+
+      peso = matriz_viavel(area, peso, N, &status);
+      if(peso == NULL){
+         resultado->status = status;
+         return status;
+      }
+      status = CAIXEIRO_ENTRADA_INVALIDA;
+
+      //escolho a tabela mais estreita em que nenhuma rota estoura:
+      //16 bits dobra os estados por linha de cache em relação ao int
+      switch(largura_custo(peso, N)){
+         case 16:
+            status = meio ? held_karp_meio_16(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota)
+                   : camadas ? held_karp_camadas_16(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota)
+                             : held_karp_16(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota);
+            break;
+         case 32:
+            status = meio ? held_karp_meio_32(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota)
+                   : camadas ? held_karp_camadas_32(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota)
+                             : held_karp_32(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota);
+            break;
+         case 64:
+            status = meio ? held_karp_meio_64(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota)
+                   : camadas ? held_karp_camadas_64(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota)
+                             : held_karp_64(area, peso, origem, N, opcoes, &resultado->custo, resultado->rota);
+            break;
+      }
+   }
+
+   if(status == CAIXEIRO_OK){
+      orientar_rota(peso, N, resultado->rota);
+      resultado->tamanho = N;
+   }
+   resultado->status = status;
+   return status;
+}
+
+struct linha_ctx{
+   int *linha;
+   int N;
+};
+
+//como grafo_busca, a primeira ocorrência de uma aresta repetida é a que vale
+static void preencher_linha_cb(int chave, int peso, void *ctx){
+   struct linha_ctx *linha = ctx;
+
+   if(chave >= 0 && chave < linha->N && linha->linha[chave] == SEM_LIGACAO) linha->linha[chave] = peso;
+}
+
+struct vizinhos_ctx{
+   uint64_t *vizinhos;
+   int N;
+};
+
+static void vizinhos_cb(int chave, int peso, void *ctx){
+   struct vizinhos_ctx *vertice = ctx;
+
+   (void) peso;
+   if(chave >= 0 && chave < vertice->N) *vertice->vizinhos |= (uint64_t)1 << chave;
+}
+
+CAIXEIRO_STATUS caixeiro_verificar(GRAFO **distancia, int N){
+   uint64_t vizinhos[CAIXEIRO_MAX_CIDADES] = {0};
+
+   if(distancia == NULL || N <= 0 || N > CAIXEIRO_MAX_CIDADES) return CAIXEIRO_ENTRADA_INVALIDA;
+
+   for(int v = 0; v < N; v++){
+      struct vizinhos_ctx vertice = { &vizinhos[v], N };
+      grafo_percorrer(distancia[v], vizinhos_cb, &vertice);
+   }
+
+   //as arestas valem nos dois sentidos para as verificações
+   for(int u = 0; u < N; u++){
+      for(uint64_t r = vizinhos[u]; r != 0; r &= r - 1) vizinhos[menor_bit(r)] |= (uint64_t)1 << u;
+   }
+
+   return viabilidade_reduzir(vizinhos, N) ? CAIXEIRO_OK : CAIXEIRO_SEM_ROTA;
+}
+
+//matriz de pesos na área a partir das listas; uma passada por lista, uma vez só
+static int *matriz_das_listas(CAIXEIRO_AREA *area, GRAFO **distancia, int N){
+   int *peso = (int*) reservar(&area->bruto, &area->bruto_cap, (size_t)N * N * sizeof(int));
+   if(peso == NULL) return NULL;
+
+   for(int i = 0; i < N * N; i++) peso[i] = SEM_LIGACAO;
+   for(int pai = 0; pai < N; pai++){
+      struct linha_ctx linha = { &peso[pai*N], N };
+      grafo_percorrer(distancia[pai], preencher_linha_cb, &linha);
+   }
+   return peso;
+}
+
+CAIXEIRO_STATUS caixeiro_resolver(CAIXEIRO_AREA *area, GRAFO **distancia, int origem, int N,
+                                  int opcoes, CAIXEIRO_RESULTADO *resultado){
+   if(area == NULL || distancia == NULL || N <= 0 || N > CAIXEIRO_MAX_CIDADES){
+      resultado->status = CAIXEIRO_ENTRADA_INVALIDA;
+      resultado->custo = 0;
+      resultado->tamanho = 0;
+      return resultado->status;
+   }
+
+   //a dp nunca mais toca nas listas
+   int *peso = matriz_das_listas(area, distancia, N);
+   if(peso == NULL){
+      resultado->status = CAIXEIRO_SEM_MEMORIA;
+      resultado->custo = 0;
+      resultado->tamanho = 0;
+      return resultado->status;
+   }
+
+   return caixeiro_resolver_matriz(area, peso, origem, N, opcoes, resultado);
+}
+
+/*
+Só responde se existe ciclo hamiltoniano, sem custos. Para cada conjunto S
+de cidades já visitadas (a origem, cidade 0, fica de fora de S) guardo em
+alcance[S] um bitset com as cidades de S em que um caminho que sai da
+origem e passa exatamente por S pode terminar. A transição é em palavra
+inteira: os sucessores de S são o OU das saídas dos finais possíveis, menos
+o próprio S. São O(2^N * N) operações e 4 bytes por conjunto, contra
+O(2^N * N^2) e 2^N * N custos da dp com pesos.
+*/
+CAIXEIRO_STATUS caixeiro_existe_rota_matriz(CAIXEIRO_AREA *area, const int *peso, int N){
+   if(area == NULL || peso == NULL || N <= 0 || N > CAIXEIRO_MAX_CIDADES) return CAIXEIRO_ENTRADA_INVALIDA;
+
+   CAIXEIRO_STATUS status;
+   peso = matriz_viavel(area, peso, N, &status);
+   if(peso == NULL) return status;
+
+   if(N == 1) return peso[0] != SEM_LIGACAO ? CAIXEIRO_OK : CAIXEIRO_SEM_ROTA;
+
+   //cidades 1..N-1 viram bits 0..M-1
+   int M = N - 1;
+   uint32_t todas = (uint32_t)(((uint64_t)1 << M) - 1);
+   uint32_t saida[CAIXEIRO_MAX_CIDADES], volta = 0;
+
+   for(int a = 0; a < M; a++){
+      saida[a] = 0;
+      for(int b = 0; b < M; b++){
+         if(peso[(a+1)*N + (b+1)] != SEM_LIGACAO) saida[a] |= (uint32_t)1 << b;
+      }
+      if(peso[(a+1)*N] != SEM_LIGACAO) volta |= (uint32_t)1 << a;
+   }
+
+   uint32_t *alcance = (uint32_t*) reservar(&area->tabela, &area->tabela_cap, ((size_t)todas + 1) * sizeof(uint32_t));
+   if(alcance == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   for(size_t S = 0; S <= todas; S++) alcance[S] = 0;
+   for(int a = 0; a < M; a++){
+      if(peso[a+1] != SEM_LIGACAO) alcance[(size_t)1 << a] = (uint32_t)1 << a;
+   }
+
+   for(size_t S = 1; S < todas; S++){
+      uint32_t finais = alcance[S];
+      if(finais == 0) continue;
+
+      uint32_t proximos = 0;
+      for(uint32_t f = finais; f != 0; f &= f - 1) proximos |= saida[menor_bit(f)];
+      proximos &= ~(uint32_t) S;
+
+      for(uint32_t p = proximos; p != 0; p &= p - 1) alcance[S | (p & -p)] |= p & -p;
+   }
+
+   return (alcance[todas] & volta) != 0 ? CAIXEIRO_OK : CAIXEIRO_SEM_ROTA;
+}
+
+CAIXEIRO_STATUS caixeiro_existe_rota(CAIXEIRO_AREA *area, GRAFO **distancia, int N){
+   if(area == NULL || distancia == NULL || N <= 0 || N > CAIXEIRO_MAX_CIDADES) return CAIXEIRO_ENTRADA_INVALIDA;
+
+   int *peso = matriz_das_listas(area, distancia, N);
+   if(peso == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   return caixeiro_existe_rota_matriz(area, peso, N);
+}
+
+/*
+Dp de Balas-Simonetti num trecho de m posições da rota, entre as cidades
+fixas antes (posição -1) e depois (posição m); a dp em si é janela_ do
+caixeiro_dp.h. Só se usam distâncias entre posições a menos de 2k uma da
+outra; elas são calculadas uma vez por trecho em `perto`, O(m * k)
+chamadas de `distancia`, e a maior delas escolhe a largura da tabela.
+*/
+static CAIXEIRO_STATUS janela_trecho(CAIXEIRO_AREA *area, int *trecho, int m, int antes, int depois, int k,
+                                     CAIXEIRO_DISTANCIA distancia, const void *ctx, uint64_t *ganho){
+   int D = 3 * k;                   //r - q em [-(k-1), 2k-1]
+   uint64_t maior = 0;
+
+   *ganho = 0;
+
+   int *perto = (int*) reservar(&area->peso, &area->peso_cap, (size_t)(m + 1) * D * sizeof(int));
+   int *ordem = (int*) reservar(&area->cidade, &area->cidade_cap, (size_t)(m + 2) * sizeof(int));
+   if(perto == NULL || ordem == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   //cidade da posição p: ordem[p + 1], com antes em -1 e depois em m
+   ordem[0] = antes;
+   for(int p = 0; p < m; p++) ordem[p + 1] = trecho[p];
+   ordem[m + 1] = depois;
+
+   //perto[(q + 1) * D + (r - q + k - 1)] = distância da posição q até r
+   for(int q = -1; q < m; q++){
+      for(int r = q - (k - 1); r <= q + 2*k - 1; r++){
+         if(r < 0 || r > m || r == q) continue;
+
+         int d = distancia(ctx, ordem[q + 1], ordem[r + 1]);
+         if(d < 0) return CAIXEIRO_ENTRADA_INVALIDA;
+         perto[(size_t)(q + 1) * D + (r - q + k - 1)] = d;
+         if((uint64_t) d > maior) maior = (uint64_t) d;
+      }
+   }
+
+   //todo caminho pelo trecho usa m + 1 arestas
+   CAIXEIRO_STATUS status = CAIXEIRO_OK;
+   switch(largura_limite(maior * (uint64_t)(m + 1))){
+      case 16: status = janela_16(area, perto, m, k, ordem, ganho); break;
+      case 32: status = janela_32(area, perto, m, k, ordem, ganho); break;
+      case 64: status = janela_64(area, perto, m, k, ordem, ganho); break;
+   }
+   if(status != CAIXEIRO_OK || *ganho == 0) return status;
+
+   //ordem[0..m-1] agora são posições do trecho; troco pelas cidades
+   for(int p = 0; p < m; p++) ordem[p] = trecho[ordem[p]];
+   for(int p = 0; p < m; p++) trecho[p] = ordem[p];
+
+   return CAIXEIRO_OK;
+}
+
+CAIXEIRO_STATUS caixeiro_melhorar(CAIXEIRO_AREA *area, int *rota, int N, int k,
+                                  CAIXEIRO_DISTANCIA distancia, const void *ctx, uint64_t *custo){
+   if(area == NULL || rota == NULL || distancia == NULL || N <= 0 || k < 2 || k > CAIXEIRO_MAX_JANELA)
+      return CAIXEIRO_ENTRADA_INVALIDA;
+
+   //trechos de 4k posições entre rota[1] e rota[N-1]; rota[0] é sempre a fronteira
+   int L = 4 * k < N - 1 ? 4 * k : N - 1;
+   int trechos = N / (L > 0 ? L : 1) + 2;
+
+   //mudou[p]: momento da última troca na posição p; rodou[t]: última vez que o
+   //trecho t rodou (as duas grades seguidas). Um trecho em que nada mudou desde
+   //a última vez, fronteiras incluídas, daria o mesmo resultado e é pulado.
+   uint32_t *mudou = (uint32_t*) reservar(&area->inicio, &area->inicio_cap,
+                                          ((size_t)N + 2 * trechos) * sizeof(uint32_t));
+   if(mudou == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   uint32_t *rodou = mudou + N, relogio = 1;
+   for(int p = 0; p < N; p++) mudou[p] = 1;
+   for(int t = 0; t < 2 * trechos; t++) rodou[t] = 0;
+
+   bool melhorou = N > 3;
+
+   while(melhorou){
+      melhorou = false;
+
+      //a segunda grade desloca os trechos em meio trecho, para as fronteiras mudarem
+      for(int deslocamento = 0; deslocamento < 2; deslocamento++){
+         int inicio = 1 + deslocamento * (L / 2);
+
+         for(int s = inicio, t = deslocamento * trechos; s < N; s += L, t++){
+            int m = s + L <= N ? L : N - s;
+            if(m < 2) continue;
+
+            uint32_t recente = mudou[s-1] > mudou[(s + m) % N] ? mudou[s-1] : mudou[(s + m) % N];
+            for(int p = s; p < s + m; p++) if(mudou[p] > recente) recente = mudou[p];
+            if(recente <= rodou[t]) continue;
+
+            uint64_t ganho;
+            CAIXEIRO_STATUS status = janela_trecho(area, &rota[s], m, rota[s-1], rota[(s + m) % N],
+                                                   k < m ? k : m, distancia, ctx, &ganho);
+            if(status != CAIXEIRO_OK) return status;
+
+            rodou[t] = ++relogio;
+            if(ganho > 0){
+               melhorou = true;
+               ++relogio;
+               for(int p = s; p < s + m; p++) mudou[p] = relogio;
+            }
+         }
+
+         //com um trecho só, deslocar não muda nada
+         if(L == N - 1) break;
+      }
+   }
+
+   *custo = 0;
+   for(int i = 0; i < N; i++){
+      int d = distancia(ctx, rota[i], rota[(i + 1) % N]);
+      if(d < 0) return CAIXEIRO_ENTRADA_INVALIDA;
+      *custo += (uint64_t) d;
+   }
+   return CAIXEIRO_OK;
+}
+
+/*
+Constantes do modelo de custo do seletor, medidas com o Makefile do
+projeto em grafos completos de 18 a 21 cidades. Uma "transição" é um
+par (estado, aresta de saída); o tempo estimado é transições / vazão.
+*/
+#define SELETOR_VAZAO_DP 1.7e8        //transições por segundo, tabela por mask (push)
+#define SELETOR_VAZAO_CAMADAS 3.0e8   //transições por segundo, camadas (pull, mais compacta)
+#define SELETOR_VAZAO_MEIO 1.2e8      //transições por segundo, pelo meio (rank por linha na junção)
+#define SELETOR_VAZAO_HEURISTICA 3.0e8
+#define SELETOR_PODA_SOBRA 0.5        //fração das transições que a poda deixa passar (pessimista)
+
+static const char *nome_motor(CAIXEIRO_MOTOR motor){
+   switch(motor){
+      case CAIXEIRO_MOTOR_DP: return "dp";
+      case CAIXEIRO_MOTOR_CAMADAS: return "camadas";
+      case CAIXEIRO_MOTOR_PODA: return "poda";
+      case CAIXEIRO_MOTOR_MEIO: return "meio";
+      case CAIXEIRO_MOTOR_HEURISTICA: return "heuristica";
+   }
+   return "?";
+}
+
+//custo da heurística: vizinho mais próximo O(N^2) e a dp da janela O(N * k^2 * 2^k)
+static double segundos_heuristica(int N){
+   double k = N - 1 < CAIXEIRO_JANELA_PADRAO ? (N > 1 ? N - 1 : 1) : CAIXEIRO_JANELA_PADRAO;
+   return ((double)N * N + (double)N * k * k * (double)((uint64_t)1 << (int)k)) / SELETOR_VAZAO_HEURISTICA;
+}
+
+/*
+MC_MEIO: guarda a camada a-1 da ida e duas da volta (até b-1), com a = M/2,
+b = M - a; as camadas a e b são calculadas linha a linha na junção.
+*/
+static void estimar_meio(int N, size_t w, double densidade, size_t *memoria, double *transicoes){
+   int M = N - 1, a = M / 2, b = M - a;
+   double binom[CAIXEIRO_MAX_CIDADES + 1];
+
+   //C(M, k) para k = 0..M
+   binom[0] = 1;
+   for(int k = 1; k <= M; k++) binom[k] = binom[k-1] * (M - k + 1) / k;
+
+   double maior = 1, soma = 0;
+   for(int k = 1; k < b; k++){
+      if(binom[k] * k > maior) maior = binom[k] * k;
+      soma += binom[k] * k * (k - 1);
+   }
+   for(int k = 1; k < a; k++) soma += binom[k] * k * (k - 1);
+   soma += M >= 2 ? binom[a] * ((double)a * (a - 1) + (double)b * (b - 1) + (double)a * b) : 0;
+
+   *memoria = (size_t)((a > 1 ? binom[a-1] * (a - 1) : 1) + 2 * maior) * w;
+   *transicoes = soma * densidade;
+}
+
+CAIXEIRO_STATUS caixeiro_escolher(CAIXEIRO_AREA *area, const int *peso, int N, const CAIXEIRO_LIMITES *limites,
+                                  CAIXEIRO_ESCOLHA *escolha, FILE *log){
+   if(area == NULL || escolha == NULL || N <= 0 || (peso == NULL && N <= CAIXEIRO_MAX_CIDADES))
+      return CAIXEIRO_ENTRADA_INVALIDA;
+
+   size_t limite_memoria = limites != NULL ? limites->memoria : 0;
+   double limite_segundos = limites != NULL ? limites->segundos : 0;
+
+   escolha->motor = CAIXEIRO_MOTOR_HEURISTICA;
+   escolha->opcoes = 0;
+   escolha->memoria = (size_t)N * sizeof(int);
+   escolha->segundos = segundos_heuristica(N);
+
+   if(N > CAIXEIRO_MAX_CIDADES){
+      if(log != NULL) fprintf(log, "seletor: N=%d acima de %d, so a heuristica (%.3g s)\n",
+                              N, CAIXEIRO_MAX_CIDADES, escolha->segundos);
+      return CAIXEIRO_OK;
+   }
+
+   //densidade e faixa dos pesos (a faixa decide a largura da tabela)
+   int arestas = 0, minimo = 0, maximo = 0;
+   for(int u = 0; u < N; u++){
+      for(int v = 0; v < N; v++){
+         int p = peso[u*N + v];
+         if(u == v || p == SEM_LIGACAO) continue;
+         if(arestas == 0 || p < minimo) minimo = p;
+         if(arestas == 0 || p > maximo) maximo = p;
+         arestas++;
+      }
+   }
+
+   int largura = largura_custo(peso, N);
+   if(largura == 0) return CAIXEIRO_ENTRADA_INVALIDA;
+
+   size_t w = (size_t) largura / 8;
+   double grau = (double) arestas / N;
+   double densidade = N > 1 ? (double) arestas / ((double)N * (N - 1)) : 1.0;
+   //estados alcançáveis (origem na mask) vezes arestas de saída de cada um
+   double transicoes = (double)((uint64_t)1 << (N - 1)) * (N - 1) * grau;
+   size_t matrizes = (size_t)N * N * (sizeof(int) + w);
+
+   //a poda só tem cota se a rota heurística existir
+   uint64_t *peso64 = matriz_peso_64(area, peso, N);
+   int rota[CAIXEIRO_MAX_CIDADES + 1];
+   if(peso64 == NULL) return CAIXEIRO_SEM_MEMORIA;
+   bool cota = rota_gulosa_64(area, peso64, N, 0, rota) != UINT64_MAX;
+
+   size_t memoria_meio;
+   double transicoes_meio;
+   estimar_meio(N, w, densidade, &memoria_meio, &transicoes_meio);
+
+   struct {
+      CAIXEIRO_MOTOR motor;
+      int opcoes;
+      size_t memoria;
+      double segundos;
+      bool disponivel;
+   } motor[] = {
+      { CAIXEIRO_MOTOR_DP, 0, ((size_t)1 << N) * N * w + matrizes, transicoes / SELETOR_VAZAO_DP, true },
+      { CAIXEIRO_MOTOR_CAMADAS, MC_CAMADAS,
+        (N > 1 ? ((size_t)1 << (N - 2)) * (N - 1) * w : w) + (N + 1) * sizeof(size_t) + matrizes,
+        transicoes / SELETOR_VAZAO_CAMADAS, true },
+      { CAIXEIRO_MOTOR_PODA, MC_PODA, ((size_t)1 << N) * N * w + matrizes,
+        transicoes * SELETOR_PODA_SOBRA / SELETOR_VAZAO_DP, cota },
+      { CAIXEIRO_MOTOR_MEIO, MC_MEIO, memoria_meio + matrizes, transicoes_meio / SELETOR_VAZAO_MEIO, true },
+   };
+   int motores = sizeof(motor) / sizeof(motor[0]), melhor = -1;
+
+   if(log != NULL) fprintf(log, "seletor: N=%d arestas=%d densidade=%.2f pesos=%d..%d (%d bits)\n",
+                           N, arestas, densidade, minimo, maximo, largura);
+
+   for(int i = 0; i < motores; i++){
+      const char *veredito = "cabe";
+
+      if(!motor[i].disponivel) veredito = "sem cota (nao achou rota gulosa)";
+      else if(limite_memoria != 0 && motor[i].memoria > limite_memoria) veredito = "excede a memoria";
+      else if(limite_segundos != 0 && motor[i].segundos > limite_segundos) veredito = "excede o tempo";
+      else if(melhor == -1 || motor[i].segundos < motor[melhor].segundos) melhor = i;
+
+      if(log != NULL) fprintf(log, "seletor: %-10s memoria=%zu bytes tempo=%.3g s: %s\n",
+                              nome_motor(motor[i].motor), motor[i].memoria, motor[i].segundos, veredito);
+   }
+
+   if(melhor != -1){
+      escolha->motor = motor[melhor].motor;
+      escolha->opcoes = motor[melhor].opcoes;
+      escolha->memoria = motor[melhor].memoria;
+      escolha->segundos = motor[melhor].segundos;
+   }
+   else escolha->memoria = matrizes;
+
+   if(log != NULL) fprintf(log, "seletor: escolhido %s\n", nome_motor(escolha->motor));
+   return CAIXEIRO_OK;
+}
+
+struct matriz_ctx{
+   const int *peso;
+   int N;
+};
+
+static int distancia_matriz(const void *ctx, int a, int b){
+   const struct matriz_ctx *matriz = ctx;
+   return matriz->peso[a * matriz->N + b];
+}
+
+/*
+Motor heurístico para N <= CAIXEIRO_MAX_CIDADES: a rota gulosa da poda
+(vizinho mais próximo + 2-opt) e, se o grafo for completo, a dp da janela
+por cima. Em grafos esparsos a janela poderia usar arestas que não existem.
+*/
+static CAIXEIRO_STATUS heuristica(CAIXEIRO_AREA *area, const int *peso, int origem, int N, uint64_t *custo, int *rota){
+   uint64_t *peso64 = matriz_peso_64(area, peso, N);
+   if(peso64 == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   *custo = rota_gulosa_64(area, peso64, N, origem, rota);
+   if(*custo == UINT64_MAX) return CAIXEIRO_SEM_ROTA;
+
+   for(int i = 0; i < N * N; i++){
+      if(i % (N + 1) != 0 && peso[i] == SEM_LIGACAO) return CAIXEIRO_OK;
+   }
+
+   struct matriz_ctx matriz = { peso, N };
+   int k = N - 1 < CAIXEIRO_JANELA_PADRAO ? N - 1 : CAIXEIRO_JANELA_PADRAO;
+   if(k < 2) return CAIXEIRO_OK;
+
+   //a janela mexe só em rota[1..N-1]; rota[N] continua sendo a origem
+   return caixeiro_melhorar(area, rota, N, k, distancia_matriz, &matriz, custo);
+}
+
+CAIXEIRO_STATUS caixeiro_resolver_auto_matriz(CAIXEIRO_AREA *area, const int *peso, int origem, int N,
+                                              const CAIXEIRO_LIMITES *limites, FILE *log,
+                                              CAIXEIRO_RESULTADO *resultado){
+   CAIXEIRO_ESCOLHA escolha;
+   CAIXEIRO_STATUS status = CAIXEIRO_ENTRADA_INVALIDA;
+
+   resultado->custo = 0;
+   resultado->tamanho = 0;
+
+   if(peso != NULL && N > 0 && N <= CAIXEIRO_MAX_CIDADES && origem >= 0 && origem < N)
+      status = caixeiro_escolher(area, peso, N, limites, &escolha, log);
+
+   if(status != CAIXEIRO_OK){
+      resultado->status = status;
+      return status;
+   }
+
+   if(escolha.motor != CAIXEIRO_MOTOR_HEURISTICA)
+      return caixeiro_resolver_matriz(area, peso, origem, N, escolha.opcoes, resultado);
+
+   //as mesmas verificações do exato: instância impossível não chega à heurística
+   peso = matriz_viavel(area, peso, N, &status);
+   if(peso != NULL) status = heuristica(area, peso, origem, N, &resultado->custo, resultado->rota);
+
+   if(status == CAIXEIRO_OK){
+      orientar_rota(peso, N, resultado->rota);
+      resultado->tamanho = N;
+   }
+   resultado->status = status;
+   return status;
+}
+
+CAIXEIRO_STATUS caixeiro_resolver_auto(CAIXEIRO_AREA *area, GRAFO **distancia, int origem, int N,
+                                       const CAIXEIRO_LIMITES *limites, FILE *log, CAIXEIRO_RESULTADO *resultado){
+   int *peso = NULL;
+
+   if(area != NULL && distancia != NULL && N > 0 && N <= CAIXEIRO_MAX_CIDADES)
+      peso = matriz_das_listas(area, distancia, N);
+
+   if(peso == NULL){
+      resultado->status = (area == NULL || distancia == NULL || N <= 0 || N > CAIXEIRO_MAX_CIDADES)
+                          ? CAIXEIRO_ENTRADA_INVALIDA : CAIXEIRO_SEM_MEMORIA;
+      resultado->custo = 0;
+      resultado->tamanho = 0;
+      return resultado->status;
+   }
+
+   return caixeiro_resolver_auto_matriz(area, peso, origem, N, limites, log, resultado);
+}
+
+void menor_caminho(GRAFO **distancia, int origem, int N){
+   menor_caminho_opcoes(distancia, origem, N, 0);
+}
+
+void menor_caminho_opcoes(GRAFO **distancia, int origem, int N, int opcoes){
+   CAIXEIRO_AREA *area = caixeiro_area_criar();
+   CAIXEIRO_RESULTADO resultado;
+
+   caixeiro_resolver(area, distancia, origem, N, opcoes, &resultado);
+   caixeiro_area_apagar(&area);
+
+   caixeiro_imprimir(&resultado, origem);
+}
+
+void caixeiro_imprimir(const CAIXEIRO_RESULTADO *resultado, int origem){
+   switch(resultado->status){
+      case CAIXEIRO_OK:
+         printf("Cidade de Origem: %d\n", origem+1);
+         printf("Rota: %d", resultado->rota[0] + 1);
+         for(int i = 1; i <= resultado->tamanho; i++) printf(" - %d", resultado->rota[i] + 1);
+         printf("\n");
+         printf("Menor distancia: %" PRIu64 "\n", resultado->custo);
+         break;
+      case CAIXEIRO_SEM_ROTA:
+         printf("Cidade de Origem: %d\n", origem+1);
+         printf("Nao existe rota\n");
+         break;
+      case CAIXEIRO_SEM_MEMORIA:
+         printf("Memoria insuficiente\n");
+         break;
+      case CAIXEIRO_ENTRADA_INVALIDA:
+         printf("Entrada invalida\n");
+         break;
+   }
+}
+
+void caixeiro_escrever(FILE *saida, const CAIXEIRO_RESULTADO *resultado){
+   switch(resultado->status){
+      case CAIXEIRO_OK:
+         fprintf(saida, "OK %" PRIu64, resultado->custo);
+         for(int i = 0; i <= resultado->tamanho; i++) fprintf(saida, " %d", resultado->rota[i] + 1);
+         fputc('\n', saida);
+         break;
+      case CAIXEIRO_SEM_ROTA: fputs("SEM_ROTA\n", saida); break;
+      case CAIXEIRO_SEM_MEMORIA: fputs("SEM_MEMORIA\n", saida); break;
+      case CAIXEIRO_ENTRADA_INVALIDA: fputs("INVALIDA\n", saida); break;
+   }
+}
@@ -0,0 +1,119 @@
+#ifndef CAIXEIRO_H
+    #define CAIXEIRO_H
+    #define CAIXEIRO_MAX_CIDADES 32 // limite das masks de 64 bits com folga para a tabela
+    #define SEM_LIGACAO -1          // valor de grafo_busca / matriz de pesos quando não há aresta
+
+    // Opções da dp (podem ser combinadas com |)
+    #define MC_CAMADAS 1 // tabela da dp em camadas por popcount, indexada pelo rank combinatório
+    #define MC_PODA 2    // descarta estados que não batem a rota heurística (cota da árvore geradora mínima)
+    #define MC_MEIO 4    // só as camadas até N/2, da origem nos dois sentidos, juntadas no meio (menos memória; ignora as outras)
+
+    #define CAIXEIRO_MAX_JANELA 12  // maior k de caixeiro_melhorar (a tabela de cada trecho cresce com 2^k)
+    #define CAIXEIRO_JANELA_PADRAO 8 // k usado pelo motor heurístico do seletor
+
+    #include<stdio.h>
+    #include<stdint.h>
+    #include<stdbool.h>
+
+    #include "Grafo.h"
+
+    typedef enum {
+        CAIXEIRO_OK,
+        CAIXEIRO_SEM_ROTA,           // não existe ciclo hamiltoniano
+        CAIXEIRO_SEM_MEMORIA,
+        CAIXEIRO_ENTRADA_INVALIDA    // origem fora do intervalo, N grande demais ou peso negativo
+    } CAIXEIRO_STATUS;
+
+    // Resultado de uma chamada; rota[0..tamanho] começa e termina na origem,
+    // no sentido da viagem. Com distâncias simétricas, das duas orientações
+    // sai a com rota[1] < rota[tamanho-1], qualquer que seja o motor.
+    typedef struct {
+        CAIXEIRO_STATUS status;
+        uint64_t custo;
+        int tamanho;
+        int rota[CAIXEIRO_MAX_CIDADES + 1];
+    } CAIXEIRO_RESULTADO;
+
+    // Área de trabalho do solver: guarda os buffers entre chamadas. Cada
+    // thread usa a sua; nada é global, então chamadas em áreas distintas
+    // podem rodar em paralelo.
+    typedef struct caixeiro_area CAIXEIRO_AREA;
+
+    CAIXEIRO_AREA *caixeiro_area_criar(void);
+    void caixeiro_area_apagar(CAIXEIRO_AREA **area);
+
+    // Resolve a partir das listas de adjacência. Sem E/S; o retorno repete resultado->status.
+    CAIXEIRO_STATUS caixeiro_resolver(CAIXEIRO_AREA *area, GRAFO **distancia, int origem, int N,
+                                      int opcoes, CAIXEIRO_RESULTADO *resultado);
+
+    // Mesmo que caixeiro_resolver, com peso[i*N + j] (SEM_LIGACAO se não há aresta).
+    CAIXEIRO_STATUS caixeiro_resolver_matriz(CAIXEIRO_AREA *area, const int *peso, int origem, int N,
+                                             int opcoes, CAIXEIRO_RESULTADO *resultado);
+
+    // Só as verificações rápidas de viabilidade.h, direto das listas, em O(N + E):
+    // CAIXEIRO_SEM_ROTA garante que não existe rota; CAIXEIRO_OK ainda pode não ter.
+    // caixeiro_resolver roda as mesmas verificações antes da dp e usa as arestas forçadas.
+    CAIXEIRO_STATUS caixeiro_verificar(GRAFO **distancia, int N);
+
+    // Só diz se existe ciclo hamiltoniano (CAIXEIRO_OK) ou não (CAIXEIRO_SEM_ROTA),
+    // com um bitset de finais por conjunto em vez da tabela de custos.
+    CAIXEIRO_STATUS caixeiro_existe_rota(CAIXEIRO_AREA *area, GRAFO **distancia, int N);
+    CAIXEIRO_STATUS caixeiro_existe_rota_matriz(CAIXEIRO_AREA *area, const int *peso, int N);
+
+    // Distância entre duas cidades, para instâncias grandes demais para a matriz N*N.
+    typedef int (*CAIXEIRO_DISTANCIA)(const void *ctx, int a, int b);
+
+    // Melhora a rota fechada rota[0..N-1] (rota[0] não sai do lugar) com a dp de
+    // Balas-Simonetti: a melhor rota em que nenhuma cidade passa à frente de outra
+    // que estava k ou mais posições antes dela. Roda em trechos de 4k posições,
+    // O(N * k^2 * 2^k) por passada, até nenhum trecho melhorar. Pesos não negativos;
+    // *custo recebe o custo da rota final.
+    CAIXEIRO_STATUS caixeiro_melhorar(CAIXEIRO_AREA *area, int *rota, int N, int k,
+                                      CAIXEIRO_DISTANCIA distancia, const void *ctx, uint64_t *custo);
+
+    // Motores que o seletor conhece.
+    typedef enum {
+        CAIXEIRO_MOTOR_DP,          // Held-Karp com a tabela por mask
+        CAIXEIRO_MOTOR_CAMADAS,     // Held-Karp só com os estados válidos, em camadas (MC_CAMADAS)
+        CAIXEIRO_MOTOR_PODA,        // Held-Karp com ramificação e poda pela cota (MC_PODA)
+        CAIXEIRO_MOTOR_MEIO,        // Held-Karp pelo meio, só as camadas até N/2 (MC_MEIO)
+        CAIXEIRO_MOTOR_HEURISTICA   // vizinho mais próximo + 2-opt + caixeiro_melhorar, sem garantia de ótimo
+    } CAIXEIRO_MOTOR;
+
+    // Orçamento do seletor; 0 é sem limite.
+    typedef struct {
+        size_t memoria;   // bytes
+        double segundos;
+    } CAIXEIRO_LIMITES;
+
+    typedef struct {
+        CAIXEIRO_MOTOR motor;
+        int opcoes;       // opções MC_* para caixeiro_resolver_matriz (motores exatos)
+        size_t memoria;   // estimativas do motor escolhido
+        double segundos;
+    } CAIXEIRO_ESCOLHA;
+
+    // Estima memória e tempo de cada motor a partir de N, densidade e faixa dos
+    // pesos e escolhe o exato mais rápido que cabe nos limites; se nenhum cabe
+    // (ou N > CAIXEIRO_MAX_CIDADES, quando peso pode ser NULL), a heurística.
+    // Com log != NULL escreve as estimativas e a decisão, uma linha por motor.
+    CAIXEIRO_STATUS caixeiro_escolher(CAIXEIRO_AREA *area, const int *peso, int N, const CAIXEIRO_LIMITES *limites,
+                                      CAIXEIRO_ESCOLHA *escolha, FILE *log);
+
+    // caixeiro_escolher seguido do motor escolhido. Na heurística, CAIXEIRO_SEM_ROTA
+    // só quer dizer que ela não achou rota.
+    CAIXEIRO_STATUS caixeiro_resolver_auto(CAIXEIRO_AREA *area, GRAFO **distancia, int origem, int N,
+                                           const CAIXEIRO_LIMITES *limites, FILE *log, CAIXEIRO_RESULTADO *resultado);
+    CAIXEIRO_STATUS caixeiro_resolver_auto_matriz(CAIXEIRO_AREA *area, const int *peso, int origem, int N,
+                                                  const CAIXEIRO_LIMITES *limites, FILE *log,
+                                                  CAIXEIRO_RESULTADO *resultado);
+
+    // Atalhos que resolvem numa área temporária e imprimem o resultado na saída padrão.
+    void menor_caminho(GRAFO **distancia, int origem, int tamanho);
+    void menor_caminho_opcoes(GRAFO **distancia, int origem, int tamanho, int opcoes);
+    // Imprime um resultado no mesmo formato de menor_caminho.
+    void caixeiro_imprimir(const CAIXEIRO_RESULTADO *resultado, int origem);
+    // Uma linha por resultado, a do servidor: "OK custo rota..." (base 1), SEM_ROTA, SEM_MEMORIA ou INVALIDA.
+    void caixeiro_escrever(FILE *saida, const CAIXEIRO_RESULTADO *resultado);
+
+#endif
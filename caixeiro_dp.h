@@ -0,0 +1,806 @@
+/*
+Modelo (template) do Held-Karp para um tipo de custo especifico.
+
+Este arquivo NAO tem include guard: ele e incluido varias vezes em caixeiro.c,
+uma vez para cada largura de custo. Antes de inclui-lo, defina:
+   CUSTO      -> tipo inteiro sem sinal usado na tabela (uint16_t, ...)
+   CUSTO_MAX  -> sentinela "infinito" (o maior valor do tipo)
+   SUFIXO     -> sufixo dos nomes gerados (16, 32, 64)
+
+Quem escolhe o tipo garante que peso_maximo * N < CUSTO_MAX, logo a soma
+de uma rota valida nunca satura; a sentinela so aparece em estados e
+ligacoes inexistentes, que sao pulados antes de qualquer soma. Na janela
+de caixeiro_melhorar o limite e o mesmo, sobre as m + 1 arestas do trecho.
+
+Nenhuma funcao daqui aloca por conta propria: todo buffer vem da area de
+trabalho (CAIXEIRO_AREA) recebida, que so cresce quando N aumenta.
+*/
+
+#define CONCATENA_(a, b) a##b
+#define CONCATENA(a, b) CONCATENA_(a, b)
+#define NOME(nome) CONCATENA(nome, SUFIXO)
+
+//peso[pai*N + filho]: aresta de pai para filho, CUSTO_MAX se não há ligação
+static CUSTO *NOME(matriz_peso_)(CAIXEIRO_AREA *area, const int *bruto, int N){
+   CUSTO *peso = (CUSTO*) reservar(&area->peso, &area->peso_cap, (size_t)N * N * sizeof(CUSTO));
+
+   if(peso == NULL) return NULL;
+
+   for(int i = 0; i < N * N; i++)
+      peso[i] = (bruto[i] == SEM_LIGACAO) ? CUSTO_MAX : (CUSTO) bruto[i];
+
+   return peso;
+}
+
+/*
+Rota heurística para a poda: vizinho mais próximo a partir da origem,
+seguida de 2-opt quando as distâncias são simétricas. Devolve o custo da
+rota (em rota[0..N], começando e terminando na origem) ou UINT64_MAX se o
+guloso ficar preso por falta de ligações.
+*/
+static uint64_t NOME(rota_gulosa_)(CAIXEIRO_AREA *area, const CUSTO *peso, int N, int origem, int *rota){
+   bool *visitado = (bool*) reservar(&area->marca, &area->marca_cap, N * sizeof(bool));
+   bool simetrico = true;
+
+   if(visitado == NULL) return UINT64_MAX;
+   for(int c = 0; c < N; c++) visitado[c] = false;
+
+   rota[0] = origem;
+   visitado[origem] = true;
+
+   for(int pos = 1; pos < N; pos++){
+      int atual = rota[pos-1], proximo = -1;
+
+      for(int c = 0; c < N; c++){
+         if(visitado[c] || peso[atual*N + c] == CUSTO_MAX) continue;
+         if(proximo == -1 || peso[atual*N + c] < peso[atual*N + proximo]) proximo = c;
+      }
+      if(proximo == -1) return UINT64_MAX;
+
+      rota[pos] = proximo;
+      visitado[proximo] = true;
+   }
+
+   rota[N] = origem;
+   if(peso[rota[N-1]*N + origem] == CUSTO_MAX) return UINT64_MAX;
+
+   for(int a = 0; a < N && simetrico; a++){
+      for(int b = 0; b < a; b++){
+         if(peso[a*N + b] != peso[b*N + a]){
+            simetrico = false;
+            break;
+         }
+      }
+   }
+
+   //2-opt: troco (a, a+1) e (b, b+1) por (a, b) e (a+1, b+1) invertendo o trecho
+   for(bool melhorou = simetrico; melhorou; ){
+      melhorou = false;
+      for(int i = 0; i + 2 < N; i++){
+         for(int j = i + 2; j < N; j++){
+            CUSTO novo_a = peso[rota[i]*N + rota[j]], novo_b = peso[rota[i+1]*N + rota[j+1]];
+            if(novo_a == CUSTO_MAX || novo_b == CUSTO_MAX) continue;
+
+            int64_t delta = (int64_t) novo_a + novo_b
+                          - (int64_t) peso[rota[i]*N + rota[i+1]] - peso[rota[j]*N + rota[j+1]];
+            if(delta >= 0) continue;
+
+            for(int x = i + 1, y = j; x < y; x++, y--){
+               int aux = rota[x]; rota[x] = rota[y]; rota[y] = aux;
+            }
+            melhorou = true;
+         }
+      }
+   }
+
+   uint64_t custo = 0;
+   for(int pos = 0; pos < N; pos++) custo += peso[rota[pos]*N + rota[pos+1]];
+   return custo;
+}
+
+/*
+Parte da cota inferior que só depende das cidades ainda não visitadas
+(`resto`, com indices originais): a árvore geradora mínima sobre elas,
+usando a menor das duas direções de cada aresta, mais a aresta mais barata
+que volta delas para a origem. Todo caminho hamiltoniano que passa pelo
+resto é uma árvore geradora dele, logo isso nunca superestima.
+UINT64_MAX se o resto não for conexo (não há como completar a rota).
+*/
+static uint64_t NOME(cota_resto_)(const CUSTO *peso, int N, int origem, uint64_t resto){
+   uint64_t chave[CAIXEIRO_MAX_CIDADES];
+   int membros[CAIXEIRO_MAX_CIDADES], k = 0;
+   uint64_t soma = 0, volta = UINT64_MAX;
+
+   for(uint64_t r = resto; r != 0; r &= r - 1) membros[k++] = menor_bit(r);
+   if(k == 0) return 0;
+
+   for(int i = 0; i < k; i++){
+      chave[i] = UINT64_MAX;
+      if(peso[membros[i]*N + origem] < volta) volta = peso[membros[i]*N + origem];
+   }
+   if(volta == CUSTO_MAX) return UINT64_MAX;
+
+   //Prim em O(k^2): membros[0..usados-1] já estão na árvore
+   chave[0] = 0;
+   for(int usados = 0; usados < k; usados++){
+      int melhor = usados;
+      for(int i = usados + 1; i < k; i++) if(chave[i] < chave[melhor]) melhor = i;
+      if(chave[melhor] == UINT64_MAX) return UINT64_MAX;
+
+      int aux = membros[usados]; membros[usados] = membros[melhor]; membros[melhor] = aux;
+      uint64_t c = chave[usados]; chave[usados] = chave[melhor]; chave[melhor] = c;
+      soma += chave[usados];
+
+      int novo = membros[usados];
+      for(int i = usados + 1; i < k; i++){
+         CUSTO ida = peso[novo*N + membros[i]], vinda = peso[membros[i]*N + novo];
+         CUSTO aresta = ida < vinda ? ida : vinda;
+         if(aresta != CUSTO_MAX && aresta < chave[i]) chave[i] = aresta;
+      }
+   }
+   return soma + volta;
+}
+
+//cota inferior para completar a rota estando em `eu`: base do resto + saída mais barata de `eu`
+static uint64_t NOME(cota_estado_)(const CUSTO *peso, int N, int origem, uint64_t resto, int eu, uint64_t base){
+   if(base == UINT64_MAX) return UINT64_MAX;
+
+   if(resto == 0)
+      return peso[eu*N + origem] == CUSTO_MAX ? UINT64_MAX : peso[eu*N + origem];
+
+   CUSTO saida = CUSTO_MAX;
+   for(uint64_t r = resto; r != 0; r &= r - 1){
+      CUSTO aresta = peso[eu*N + menor_bit(r)];
+      if(aresta < saida) saida = aresta;
+   }
+   return saida == CUSTO_MAX ? UINT64_MAX : base + saida;
+}
+
+static CAIXEIRO_STATUS NOME(held_karp_)(CAIXEIRO_AREA *area, const int *bruto, int origem, int N, int opcoes,
+                                        uint64_t *menor, int *rota){
+   size_t total = (size_t)1 << N;
+
+   CUSTO *peso = NOME(matriz_peso_)(area, bruto, N);
+   if(peso == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   //dp[mask*N + j]:
+   //estou na mask e o ultimo que visitei foi o "j",
+   //guardo a menor distância até esse node j, passando por todos que estão ativos na minha mask;
+   CUSTO *dp = (CUSTO*) reservar(&area->tabela, &area->tabela_cap, total * N * sizeof(CUSTO));
+   if(dp == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   for(size_t i = 0; i < total * N; i++) dp[i] = CUSTO_MAX;
+
+   dp[((size_t)1 << origem)*N + origem] = 0;
+   //O ultimo que visitei foi a origem, e só tenho a origem ligada na minha mask
+
+   //Com MC_PODA, a rota heurística vira a cota superior: um estado cujo valor
+   //mais a cota inferior para terminar a rota não fica abaixo dela é apagado
+   //(vira CUSTO_MAX) antes de propagar
+   uint64_t cota = (opcoes & MC_PODA) ? NOME(rota_gulosa_)(area, peso, N, origem, rota) : UINT64_MAX;
+
+   for(size_t mask = 1; mask < total; mask++){ //passo por todas as mask
+      if((mask & ((size_t)1 << origem)) == 0) continue; //a origem não está ativa
+
+      CUSTO *linha = &dp[mask*N];
+      uint64_t resto = (total - 1) & ~mask;
+      uint64_t base = 0;
+      bool base_pronta = false;
+
+      for(int pai = 0; pai < N; pai++){
+         if((mask & ((size_t)1 << pai)) == 0 || linha[pai] == CUSTO_MAX) continue;
+         //o pai não está na mask, ou ainda não é alcançável -> nada a propagar
+
+         if(opcoes & MC_PODA){
+            if(!base_pronta){
+               base = NOME(cota_resto_)(peso, N, origem, resto);
+               base_pronta = true;
+            }
+            uint64_t falta = NOME(cota_estado_)(peso, N, origem, resto, pai, base);
+            if(falta == UINT64_MAX || linha[pai] + falta >= cota){
+               linha[pai] = CUSTO_MAX;
+               continue;
+            }
+         }
+
+         CUSTO *aresta = &peso[pai*N];
+
+         for(int filho = 0; filho < N; filho++){
+            if(aresta[filho] == CUSTO_MAX || (mask & ((size_t)1 << filho)) != 0) continue;
+
+            CUSTO novo = (CUSTO)(linha[pai] + aresta[filho]);
+            CUSTO *alvo = &dp[(mask | ((size_t)1 << filho))*N + filho];
+
+            if(novo < *alvo) *alvo = novo; //Transição da minha dp
+         }
+      }
+   }
+
+   size_t cheia = total - 1; //mask com todos os nodes visitados
+   uint64_t resp = cota;
+   int ultimo = -1;
+
+   //fecho o ciclo: ultimo visitado volta para a origem
+   for(int i = 0; i < N; i++){
+      if(peso[i*N + origem] == CUSTO_MAX || dp[cheia*N + i] == CUSTO_MAX) continue;
+
+      uint64_t candidato = (uint64_t) dp[cheia*N + i] + peso[i*N + origem];
+      if(candidato < resp){
+         resp = candidato;
+         ultimo = i;
+      }
+   }
+
+   if(ultimo != -1){
+      //Refaço o caminho de trás para frente: o pai de (mask, eu) é o menor
+      //node da mask cuja transição reproduz exatamente dp[mask][eu], que é o
+      //mesmo pai que a transição estrita (<) escolheria durante a dp. A rota
+      //é preenchida do fim para o começo, então sai no sentido da viagem.
+      int eu = ultimo;
+      size_t mask = cheia;
+
+      rota[0] = rota[N] = origem;
+
+      for(int pos = N - 1; pos >= 1; pos--){
+         size_t anterior = mask - ((size_t)1 << eu);
+         int pai = 0;
+
+         rota[pos] = eu;
+
+         for(; pai < N; pai++){
+            if((anterior & ((size_t)1 << pai)) == 0) continue;
+            if(dp[anterior*N + pai] == CUSTO_MAX || peso[pai*N + eu] == CUSTO_MAX) continue;
+            if((CUSTO)(dp[anterior*N + pai] + peso[pai*N + eu]) == dp[mask*N + eu]) break;
+         }
+
+         mask = anterior;
+         eu = pai;
+      }
+   }
+
+   //sem rota abaixo da cota, a própria rota heurística (já em `rota`) é a ótima
+   if(resp == UINT64_MAX) return CAIXEIRO_SEM_ROTA;
+
+   *menor = resp;
+   return CAIXEIRO_OK;
+}
+
+/*
+Mesmo Held-Karp, mas com a tabela separada em camadas pelo numero de
+cidades visitadas (sem contar a origem, que está em toda mask).
+
+A camada k guarda apenas os subconjuntos S com |S| = k, um atrás do outro,
+na ordem do sistema de numeração combinatório: rank(S) = soma C(c_i, i),
+com c_1 < c_2 < ... < c_k os elementos de S. Essa ordem é a mesma ordem
+numérica das masks de mesmo popcount, então o Gosper's hack percorre a
+camada escrevendo linha após linha. Cada linha tem só k colunas (uma por
+elemento de S), em vez das N colunas da tabela por mask.
+
+A transição é "puxada": para cada (T, f) da camada k+1 leio a linha de
+T - {f} na camada k, então escrevo em sequência e cada leitura é uma linha
+contígua. As cidades diferentes da origem são renumeradas 0..M-1.
+*/
+static CAIXEIRO_STATUS NOME(held_karp_camadas_)(CAIXEIRO_AREA *area, const int *bruto, int origem, int N, int opcoes,
+                                                uint64_t *menor, int *rota){
+   int M = N - 1;
+   CUSTO *peso = NOME(matriz_peso_)(area, bruto, N);
+   int *cidade = (int*) reservar(&area->cidade, &area->cidade_cap, N * sizeof(int)); //cidade[a]: indice original
+   size_t *inicio = (size_t*) reservar(&area->inicio, &area->inicio_cap, (N + 1) * sizeof(size_t)); //inicio[k]: primeira posição da camada k
+   size_t binom[CAIXEIRO_MAX_CIDADES][CAIXEIRO_MAX_CIDADES];
+
+   if(peso == NULL || cidade == NULL || inicio == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   for(int a = 0, c = 0; c < N; c++){
+      if(c != origem) cidade[a++] = c;
+   }
+
+   if(M == 0){
+      //só existe a origem: a rota é o laço dela mesma, se existir
+      if(peso[origem*N + origem] == CUSTO_MAX) return CAIXEIRO_SEM_ROTA;
+
+      *menor = peso[origem*N + origem];
+      rota[0] = rota[1] = origem;
+      return CAIXEIRO_OK;
+   }
+
+   for(int n = 0; n <= M; n++){
+      binom[n][0] = 1;
+      for(int k = 1; k <= n; k++) binom[n][k] = binom[n-1][k-1] + (k < n ? binom[n-1][k] : 0);
+      for(int k = n + 1; k <= M; k++) binom[n][k] = 0;
+   }
+
+   inicio[0] = inicio[1] = 0;
+   for(int k = 1; k <= M; k++) inicio[k+1] = inicio[k] + binom[M][k] * k;
+
+   CUSTO *tabela = (CUSTO*) reservar(&area->tabela, &area->tabela_cap, inicio[M+1] * sizeof(CUSTO));
+   if(tabela == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   //Mesma poda do layout por mask (MC_PODA), aplicada a cada (T, f) logo
+   //depois de calculado; `todas` são as M cidades renumeradas
+   uint64_t todas = ((uint64_t)1 << M) - 1;
+   uint64_t cota = (opcoes & MC_PODA) ? NOME(rota_gulosa_)(area, peso, N, origem, rota) : UINT64_MAX;
+
+   //camada 1: S = {f}, rank(S) = C(f, 1) = f, vindo direto da origem
+   for(int f = 0; f < M; f++){
+      tabela[f] = peso[origem*N + cidade[f]];
+
+      if((opcoes & MC_PODA) && tabela[f] != CUSTO_MAX){
+         uint64_t resto = reinsere_origem(todas & ~((uint64_t)1 << f), origem);
+         uint64_t falta = NOME(cota_estado_)(peso, N, origem, resto, cidade[f],
+                                             NOME(cota_resto_)(peso, N, origem, resto));
+         if(falta == UINT64_MAX || tabela[f] + falta >= cota) tabela[f] = CUSTO_MAX;
+      }
+   }
+
+   int bits[CAIXEIRO_MAX_CIDADES];
+   size_t prefixo[CAIXEIRO_MAX_CIDADES + 1], sufixo[CAIXEIRO_MAX_CIDADES + 1];
+
+   for(int k = 1; k < M; k++){
+      CUSTO *origem_camada = &tabela[inicio[k]];
+      CUSTO *destino = &tabela[inicio[k+1]];
+      uint64_t limite = (uint64_t)1 << M;
+      size_t r = 0;
+
+      for(uint64_t T = ((uint64_t)1 << (k+1)) - 1; T < limite; r++){
+         uint64_t resto = reinsere_origem(todas & ~T, origem);
+         uint64_t base = 0;
+         bool base_pronta = false;
+         int q = 0;
+         for(uint64_t t = T; t != 0; t &= t - 1) bits[q++] = menor_bit(t);
+
+         //rank(T - {c_p}) = soma_{i<p} C(c_i, i) + soma_{i>p} C(c_i, i-1)  (i a partir de 1)
+         prefixo[0] = 0;
+         for(int i = 0; i <= k; i++) prefixo[i+1] = prefixo[i] + binom[bits[i]][i+1];
+         sufixo[k+1] = 0;
+         for(int i = k; i >= 0; i--) sufixo[i] = sufixo[i+1] + binom[bits[i]][i];
+
+         for(int p = 0; p <= k; p++){
+            int f = cidade[bits[p]];
+            CUSTO *linha = &origem_camada[(prefixo[p] + sufixo[p+1]) * k];
+            CUSTO melhor = CUSTO_MAX;
+
+            for(int i = 0; i <= k; i++){
+               if(i == p) continue;
+               CUSTO anterior = linha[i < p ? i : i - 1];
+               CUSTO aresta = peso[cidade[bits[i]]*N + f];
+
+               if(anterior == CUSTO_MAX || aresta == CUSTO_MAX) continue;
+
+               CUSTO novo = (CUSTO)(anterior + aresta);
+               if(novo < melhor) melhor = novo;
+            }
+
+            if((opcoes & MC_PODA) && melhor != CUSTO_MAX){
+               if(!base_pronta){
+                  base = NOME(cota_resto_)(peso, N, origem, resto);
+                  base_pronta = true;
+               }
+               uint64_t falta = NOME(cota_estado_)(peso, N, origem, resto, f, base);
+               if(falta == UINT64_MAX || melhor + falta >= cota) melhor = CUSTO_MAX;
+            }
+            destino[r*(k+1) + p] = melhor;
+         }
+
+         //Gosper's hack: próxima mask com o mesmo popcount
+         uint64_t c = T & -T;
+         uint64_t s = T + c;
+         T = (((s ^ T) >> 2) / c) | s;
+      }
+   }
+
+   //a última camada tem uma linha só: todas as cidades visitadas
+   CUSTO *cheia = &tabela[inicio[M]];
+   uint64_t resp = cota;
+   int ultimo = -1;
+
+   for(int p = 0; p < M; p++){
+      CUSTO volta = peso[cidade[p]*N + origem];
+      if(cheia[p] == CUSTO_MAX || volta == CUSTO_MAX) continue;
+
+      if((uint64_t) cheia[p] + volta < resp){
+         resp = (uint64_t) cheia[p] + volta;
+         ultimo = p;
+      }
+   }
+
+   if(ultimo != -1){
+      //volto camada por camada, escolhendo o menor predecessor que reproduz o
+      //valor, e preencho a rota do fim para o começo (sentido da viagem)
+      uint64_t T = ((uint64_t)1 << M) - 1;
+      int eu = ultimo;
+
+      rota[0] = rota[N] = origem;
+      rota[N-1] = cidade[eu];
+
+      for(int k = M; k > 1; k--){
+         uint64_t S = T & ~((uint64_t)1 << eu);
+         size_t rank_T = 0, rank_S = 0;
+         int i = 0, pos_eu = 0;
+
+         for(uint64_t resto = T; resto != 0; resto &= resto - 1, i++){
+            int b = menor_bit(resto);
+            rank_T += binom[b][i+1];
+            if(b == eu) pos_eu = i;
+         }
+         i = 0;
+         for(uint64_t resto = S; resto != 0; resto &= resto - 1, i++) rank_S += binom[menor_bit(resto)][i+1];
+
+         CUSTO alvo = tabela[inicio[k] + rank_T*k + pos_eu];
+         CUSTO *linha = &tabela[inicio[k-1] + rank_S*(k-1)];
+         int pai = -1;
+
+         i = 0;
+         for(uint64_t resto = S; resto != 0; resto &= resto - 1, i++){
+            int b = menor_bit(resto);
+            CUSTO aresta = peso[cidade[b]*N + cidade[eu]];
+
+            if(linha[i] == CUSTO_MAX || aresta == CUSTO_MAX) continue;
+            if((CUSTO)(linha[i] + aresta) == alvo){
+               pai = b;
+               break;
+            }
+         }
+
+         rota[k-1] = cidade[pai];
+         T = S;
+         eu = pai;
+      }
+   }
+
+   //sem rota abaixo da cota, a própria rota heurística (já em `rota`) é a ótima
+   if(resp == UINT64_MAX) return CAIXEIRO_SEM_ROTA;
+
+   *menor = resp;
+   return CAIXEIRO_OK;
+}
+
+/*
+Uma linha (T, *) do Held-Karp em camadas, puxada da camada k-1 como em
+held_karp_camadas_, sem poda; bits[0..k-1] são os elementos de T em ordem.
+Com `volta` a linha é a dos caminhos que começam em f, passam pelo resto
+de T e terminam na origem: as arestas são lidas no sentido contrário.
+*/
+static void NOME(linha_)(const CUSTO *peso, int N, int origem, const int *cidade, int k, const int *bits,
+                         size_t binom[][CAIXEIRO_MAX_CIDADES], bool volta, const CUSTO *anterior, CUSTO *saida){
+   size_t prefixo[CAIXEIRO_MAX_CIDADES + 1], sufixo[CAIXEIRO_MAX_CIDADES + 1];
+
+   if(k == 1){
+      int f = cidade[bits[0]];
+      saida[0] = volta ? peso[f*N + origem] : peso[origem*N + f];
+      return;
+   }
+
+   prefixo[0] = 0;
+   for(int i = 0; i < k; i++) prefixo[i+1] = prefixo[i] + binom[bits[i]][i+1];
+   sufixo[k] = 0;
+   for(int i = k - 1; i >= 0; i--) sufixo[i] = sufixo[i+1] + binom[bits[i]][i];
+
+   for(int p = 0; p < k; p++){
+      int f = cidade[bits[p]];
+      const CUSTO *linha = &anterior[(prefixo[p] + sufixo[p+1]) * (k - 1)];
+      CUSTO melhor = CUSTO_MAX;
+
+      for(int i = 0; i < k; i++){
+         if(i == p) continue;
+         CUSTO antes = linha[i < p ? i : i - 1];
+         CUSTO aresta = volta ? peso[f*N + cidade[bits[i]]] : peso[cidade[bits[i]]*N + f];
+
+         if(antes == CUSTO_MAX || aresta == CUSTO_MAX) continue;
+
+         CUSTO novo = (CUSTO)(antes + aresta);
+         if(novo < melhor) melhor = novo;
+      }
+      saida[p] = melhor;
+   }
+}
+
+//a camada k inteira, linha por linha na ordem do rank (Gosper's hack)
+static void NOME(camada_)(const CUSTO *peso, int N, int origem, const int *cidade, int M, int k,
+                          size_t binom[][CAIXEIRO_MAX_CIDADES], bool volta,
+                          const CUSTO *anterior, CUSTO *destino){
+   int bits[CAIXEIRO_MAX_CIDADES];
+   uint64_t limite = (uint64_t)1 << M;
+   size_t r = 0;
+
+   for(uint64_t T = ((uint64_t)1 << k) - 1; T < limite; r++){
+      int q = 0;
+      for(uint64_t t = T; t != 0; t &= t - 1) bits[q++] = menor_bit(t);
+
+      NOME(linha_)(peso, N, origem, cidade, k, bits, binom, volta, anterior, &destino[r*k]);
+
+      uint64_t c = T & -T;
+      uint64_t s = T + c;
+      T = (((s ^ T) >> 2) / c) | s;
+   }
+}
+
+/*
+Caminho ótimo entre a origem e membros[fim] passando exatamente por
+membros[0..n-1] (n pequeno, até metade das cidades), com a tabela por mask
+inteira em `dp`. Sem `volta` o caminho sai da origem e termina em
+membros[fim]; com `volta`, sai de membros[fim] e termina na origem.
+saida[0..n-1] recebe as cidades a partir da ponta longe da origem, ou
+seja, membros[fim] primeiro.
+*/
+static void NOME(caminho_)(const CUSTO *peso, int N, int origem, const int *membros, int n, int fim, bool volta,
+                           CUSTO *dp, int *saida){
+   size_t total = (size_t)1 << n;
+
+   #define ARESTA(de, para) (volta ? peso[(para)*N + (de)] : peso[(de)*N + (para)])
+
+   for(size_t i = 0; i < total * n; i++) dp[i] = CUSTO_MAX;
+   for(int j = 0; j < n; j++) dp[((size_t)1 << j)*n + j] = ARESTA(origem, membros[j]);
+
+   for(size_t mask = 1; mask < total; mask++){
+      for(int j = 0; j < n; j++){
+         CUSTO atual = dp[mask*n + j];
+         if(atual == CUSTO_MAX) continue;
+
+         for(int e = 0; e < n; e++){
+            if(mask & ((size_t)1 << e)) continue;
+            CUSTO aresta = ARESTA(membros[j], membros[e]);
+            if(aresta == CUSTO_MAX) continue;
+
+            CUSTO novo = (CUSTO)(atual + aresta);
+            CUSTO *alvo = &dp[(mask | ((size_t)1 << e))*n + e];
+            if(novo < *alvo) *alvo = novo;
+         }
+      }
+   }
+
+   size_t mask = total - 1;
+   int eu = fim;
+   for(int pos = 0; pos < n; pos++){
+      saida[pos] = membros[eu];
+
+      size_t anterior = mask & ~((size_t)1 << eu);
+      int pai = 0;
+      for(; anterior != 0 && pai < n; pai++){
+         if((anterior & ((size_t)1 << pai)) == 0 || dp[anterior*n + pai] == CUSTO_MAX) continue;
+         CUSTO aresta = ARESTA(membros[pai], membros[eu]);
+         if(aresta != CUSTO_MAX && (CUSTO)(dp[anterior*n + pai] + aresta) == dp[mask*n + eu]) break;
+      }
+      mask = anterior;
+      eu = pai;
+   }
+
+   #undef ARESTA
+}
+
+/*
+Held-Karp pelo meio: em vez de todas as camadas, calcula as da ida (caminhos
+origem -> ... -> f) até a - 1, com a = M/2, e as da volta (f -> ... ->
+origem) até b - 1, com b = M - a, guardando só a última da ida e duas da
+volta de cada vez. Uma rota é ida por S (|S| = a, termina em f) + aresta
+f -> g + volta pelo complemento T (|T| = b, começa em g). A junção percorre
+os S de tamanho a em ordem e calcula na hora as linhas de S (da camada
+a - 1 da ida) e de T (da camada b - 1 da volta, achada pelo rank), então
+nem as camadas a e b chegam a existir.
+
+O pico de memória cai de M * 2^(M-1) para perto de 3 * C(M, M/2) * M/2
+estados. As camadas intermediárias não ficam guardadas, então a rota é
+refeita depois com dps por mask pequenas, só dentro de S e de T.
+MC_PODA não se aplica aqui.
+*/
+static CAIXEIRO_STATUS NOME(held_karp_meio_)(CAIXEIRO_AREA *area, const int *bruto, int origem, int N, int opcoes,
+                                             uint64_t *menor, int *rota){
+   int M = N - 1;
+
+   //com menos de duas cidades além da origem não há meio para juntar
+   if(M < 2) return NOME(held_karp_camadas_)(area, bruto, origem, N, opcoes & ~MC_PODA, menor, rota);
+
+   CUSTO *peso = NOME(matriz_peso_)(area, bruto, N);
+   int *cidade = (int*) reservar(&area->cidade, &area->cidade_cap, N * sizeof(int));
+   size_t binom[CAIXEIRO_MAX_CIDADES][CAIXEIRO_MAX_CIDADES];
+
+   if(peso == NULL || cidade == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   for(int a = 0, c = 0; c < N; c++){
+      if(c != origem) cidade[a++] = c;
+   }
+
+   for(int n = 0; n <= M; n++){
+      binom[n][0] = 1;
+      for(int k = 1; k <= n; k++) binom[n][k] = binom[n-1][k-1] + (k < n ? binom[n-1][k] : 0);
+      for(int k = n + 1; k <= M; k++) binom[n][k] = 0;
+   }
+
+   int a = M / 2, b = M - a;
+   size_t maior = 1;
+   for(int k = 1; k < b; k++) if(binom[M][k] * k > maior) maior = binom[M][k] * k;
+
+   //[ida na camada a-1 | duas camadas de trabalho]; ida e volta só usam as
+   //de trabalho até a-1 <= b-1, então o mesmo `maior` serve às duas
+   size_t tam_ida = a > 1 ? binom[M][a-1] * (a-1) : 1;
+   CUSTO *tabela = (CUSTO*) reservar(&area->tabela, &area->tabela_cap, (tam_ida + 2 * maior) * sizeof(CUSTO));
+   if(tabela == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   CUSTO *ida = tabela, *trabalho[2] = { tabela + tam_ida, tabela + tam_ida + maior };
+
+   for(int k = 1; k < a; k++){
+      CUSTO *destino = k == a - 1 ? ida : trabalho[k & 1];
+      NOME(camada_)(peso, N, origem, cidade, M, k, binom, false, trabalho[(k - 1) & 1], destino);
+   }
+   for(int k = 1; k < b; k++)
+      NOME(camada_)(peso, N, origem, cidade, M, k, binom, true, trabalho[(k - 1) & 1], trabalho[k & 1]);
+   CUSTO *volta = trabalho[(b - 1) & 1];
+
+   //junção em fluxo pelos S de tamanho a
+   uint64_t todas = ((uint64_t)1 << M) - 1, melhor_S = 0;
+   uint64_t resp = UINT64_MAX;
+   int melhor_f = -1, melhor_g = -1;
+
+   for(uint64_t S = ((uint64_t)1 << a) - 1; S <= todas; ){
+      int bits_S[CAIXEIRO_MAX_CIDADES], bits_T[CAIXEIRO_MAX_CIDADES], i = 0;
+      CUSTO linha_ida[CAIXEIRO_MAX_CIDADES], linha_volta[CAIXEIRO_MAX_CIDADES];
+
+      for(uint64_t s = S; s != 0; s &= s - 1) bits_S[i++] = menor_bit(s);
+      i = 0;
+      for(uint64_t t = todas & ~S; t != 0; t &= t - 1) bits_T[i++] = menor_bit(t);
+
+      NOME(linha_)(peso, N, origem, cidade, a, bits_S, binom, false, ida, linha_ida);
+      NOME(linha_)(peso, N, origem, cidade, b, bits_T, binom, true, volta, linha_volta);
+
+      for(int p = 0; p < a; p++){
+         if(linha_ida[p] == CUSTO_MAX) continue;
+         int f = bits_S[p];
+
+         for(int q = 0; q < b; q++){
+            CUSTO aresta = peso[cidade[f]*N + cidade[bits_T[q]]];
+            if(linha_volta[q] == CUSTO_MAX || aresta == CUSTO_MAX) continue;
+
+            uint64_t total = (uint64_t) linha_ida[p] + aresta + linha_volta[q];
+            if(total < resp){
+               resp = total;
+               melhor_S = S;
+               melhor_f = f;
+               melhor_g = bits_T[q];
+            }
+         }
+      }
+
+      uint64_t c = S & -S;
+      uint64_t s = S + c;
+      S = (((s ^ S) >> 2) / c) | s;
+   }
+
+   if(resp == UINT64_MAX) return CAIXEIRO_SEM_ROTA;
+
+   //refaço as duas metades; a tabela das camadas já não é necessária
+   CUSTO *dp = (CUSTO*) reservar(&area->tabela, &area->tabela_cap, ((size_t)1 << b) * b * sizeof(CUSTO));
+   if(dp == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+   int membros[CAIXEIRO_MAX_CIDADES], n = 0, fim = 0, metade[CAIXEIRO_MAX_CIDADES];
+
+   for(uint64_t s = melhor_S; s != 0; s &= s - 1){
+      if(menor_bit(s) == melhor_f) fim = n;
+      membros[n++] = cidade[menor_bit(s)];
+   }
+   NOME(caminho_)(peso, N, origem, membros, n, fim, false, dp, metade);
+   for(int i = 0; i < a; i++) rota[a - i] = metade[i];
+
+   n = 0;
+   for(uint64_t t = todas & ~melhor_S; t != 0; t &= t - 1){
+      if(menor_bit(t) == melhor_g) fim = n;
+      membros[n++] = cidade[menor_bit(t)];
+   }
+   NOME(caminho_)(peso, N, origem, membros, n, fim, true, dp, metade);
+   for(int i = 0; i < b; i++) rota[a + 1 + i] = metade[i];
+
+   rota[0] = rota[N] = origem;
+   *menor = resp;
+   return CAIXEIRO_OK;
+}
+
+/*
+Dp de Balas-Simonetti de um trecho de m posições de caixeiro_melhorar, com
+as distâncias `perto` já calculadas por janela_trecho (a posição -1 e a m
+são as cidades fixas das pontas). A restrição é: se a posição p vem k ou
+mais posições antes de q na rota atual, p continua antes de q. Com ela o
+conjunto de posições já colocadas é sempre {0..b-1}, mais algumas de
+b+1..b+k-1, com b a menor ainda livre; o estado é (b, mask das k-1
+posições depois de b, ultimo - b), e a última colocada fica em
+[b-k, b+k-1]. A próxima é b ou uma posição livre da mask, então cada
+estado tem no máximo k sucessores e o trecho custa O(m * k^2 * 2^k).
+
+Aqui quem escolhe o tipo garante que maior distância * (m + 1) < CUSTO_MAX.
+Se achar uma ordem mais barata, põe suas posições em ordem[0..m-1] e a
+diferença em *ganho (que fica 0 caso contrário).
+*/
+static CAIXEIRO_STATUS NOME(janela_)(CAIXEIRO_AREA *area, const int *perto, int m, int k, int *ordem, uint64_t *ganho){
+   size_t M = (size_t)1 << (k - 1);
+   int W = 2 * k;                   //ultimo - b em [-k, k-1]
+   int D = 3 * k;                   //r - q em [-(k-1), 2k-1]
+   size_t estados = (size_t)(m + 1) * M * W;
+
+   *ganho = 0;
+
+   CUSTO *custo = (CUSTO*) reservar(&area->tabela, &area->tabela_cap, estados * sizeof(CUSTO));
+   int8_t *anterior = (int8_t*) reservar(&area->marca, &area->marca_cap, estados * sizeof(int8_t));
+   if(custo == NULL || anterior == NULL) return CAIXEIRO_SEM_MEMORIA;
+
+#define PERTO(q, r) ((CUSTO) perto[(size_t)((q) + 1) * D + ((r) - (q) + k - 1)])
+#define ESTADO(b, mask, u) ((((size_t)(b) * M + (mask)) * W) + (size_t)((u) + k))
+
+   uint64_t atual = 0;
+   for(int p = 0; p <= m; p++) atual += PERTO(p - 1, p);
+
+   for(size_t i = 0; i < estados; i++) custo[i] = CUSTO_MAX;
+   custo[ESTADO(0, 0, -1)] = 0;
+
+   for(int b = 0; b < m; b++){
+      int bits = m - 1 - b < k - 1 ? m - 1 - b : k - 1;
+
+      for(size_t mask = 0; mask < ((size_t)1 << bits); mask++){
+         //colocar b leva para a próxima posição livre depois das já colocadas em seguida
+         int t = menor_bit(~(uint64_t) mask);
+         int nb = b + 1 + t;
+         size_t nmask = mask >> (t + 1);
+
+         for(int u = -k; u < k; u++){
+            CUSTO valor = custo[ESTADO(b, mask, u)];
+            if(valor == CUSTO_MAX) continue;
+
+            int q = b + u;
+            size_t destino = ESTADO(nb, nmask, b - nb);
+            CUSTO novo = (CUSTO)(valor + PERTO(q, b));
+
+            if(novo < custo[destino]){
+               custo[destino] = novo;
+               anterior[destino] = (int8_t) u;
+            }
+
+            for(int i = 0; i < bits; i++){
+               if(mask & ((size_t)1 << i)) continue;
+
+               destino = ESTADO(b, mask | ((size_t)1 << i), i + 1);
+               novo = (CUSTO)(valor + PERTO(q, b + 1 + i));
+               if(novo < custo[destino]){
+                  custo[destino] = novo;
+                  anterior[destino] = (int8_t) u;
+               }
+            }
+         }
+      }
+   }
+
+   uint64_t melhor = UINT64_MAX;
+   int u = 0;
+   for(int v = -k; v < 0; v++){
+      if(m + v < 0 || custo[ESTADO(m, 0, v)] == CUSTO_MAX) continue;
+
+      uint64_t valor = (uint64_t) custo[ESTADO(m, 0, v)] + PERTO(m + v, m);
+      if(valor < melhor){
+         melhor = valor;
+         u = v;
+      }
+   }
+
+   //a ordem atual é um dos caminhos da dp, então melhor <= atual
+   if(melhor >= atual) return CAIXEIRO_OK;
+
+   //refaço de trás para frente: tirar a última colocada q dá o estado anterior
+   int b = m, pos = m;
+   size_t mask = 0;
+   while(!(b == 0 && u == -1)){
+      int q = b + u;
+      int pu = anterior[ESTADO(b, mask, u)];
+
+      ordem[--pos] = q;
+      if(u < 0){
+         mask = ((((size_t)1 << (b - q - 1)) - 1) | (mask << (b - q))) & (M - 1);
+         b = q;
+      }
+      else mask &= ~((size_t)1 << (u - 1));
+      u = pu;
+   }
+#undef PERTO
+#undef ESTADO
+
+   *ganho = atual - melhor;
+   return CAIXEIRO_OK;
+}
+
+#undef NOME
+#undef CONCATENA
+#undef CONCATENA_
@@ -0,0 +1,137 @@
+#include "instancia.h"
+#include "caixeiro.h"
+#include "tsplib.h"
+
+#include<stdlib.h>
+#include<stdint.h>
+#include<string.h>
+#include<ctype.h>
+
+/*
+Matriz de uma instância com N cidades: o buffer de quem chamou
+(instancia_ler_em, que tem espaço para qualquer N aceito) ou uma nova.
+*/
+static int *matriz_destino(int *buffer, int N){
+   return buffer != NULL ? buffer : (int*) malloc((size_t)N * N * sizeof(int));
+}
+
+static void matriz_descartar(int *buffer, int *peso){
+   if(peso != buffer) free(peso);
+}
+
+static bool instancia_ler_texto(FILE *entrada, INSTANCIA *instancia, int *buffer){
+   int cidades, origem, ligacoes;
+
+   if(fscanf(entrada, "%d %d %d", &cidades, &origem, &ligacoes) != 3) return false;
+   if(cidades <= 0 || cidades > CAIXEIRO_MAX_CIDADES || ligacoes < 0) return false;
+
+   int *peso = matriz_destino(buffer, cidades);
+   if(peso == NULL) return false;
+
+   for(int i = 0; i < cidades * cidades; i++) peso[i] = SEM_LIGACAO;
+
+   for(int i = 0; i < ligacoes; i++){
+      int a, b, p;
+
+      if(fscanf(entrada, "%d %d %d", &a, &b, &p) != 3 || a < 1 || a > cidades || b < 1 || b > cidades){
+         matriz_descartar(buffer, peso);
+         return false;
+      }
+      a--; b--; // Base 0.
+      peso[a*cidades + b] = p;
+      peso[b*cidades + a] = p;
+   }
+
+   instancia->N = cidades;
+   instancia->origem = origem - 1;
+   instancia->peso = peso;
+   return true;
+}
+
+//a assinatura "CXB1" já foi consumida por instancia_ler
+static bool instancia_ler_binario(FILE *entrada, INSTANCIA *instancia, int *buffer){
+   int32_t cabecalho[2];
+
+   if(fread(cabecalho, sizeof(int32_t), 2, entrada) != 2) return false;
+
+   int N = cabecalho[0];
+   if(N <= 0 || N > CAIXEIRO_MAX_CIDADES) return false;
+
+   int *peso = matriz_destino(buffer, N);
+   if(peso == NULL) return false;
+
+   //uma linha por vez: int32 no arquivo, int na matriz
+   for(int i = 0; i < N; i++){
+      int32_t linha[CAIXEIRO_MAX_CIDADES];
+
+      if(fread(linha, sizeof(int32_t), N, entrada) != (size_t)N){
+         matriz_descartar(buffer, peso);
+         return false;
+      }
+      for(int j = 0; j < N; j++) peso[i*N + j] = linha[j];
+   }
+
+   instancia->N = N;
+   instancia->origem = cabecalho[1];
+   instancia->peso = peso;
+   return true;
+}
+
+//TSPLIB pequena o bastante para a dp: a matriz é calculada em blocos direto das coordenadas
+static bool instancia_ler_tsplib(FILE *entrada, const char *lido, INSTANCIA *instancia, int *buffer){
+   TSPLIB tsplib;
+
+   if(!tsplib_ler(entrada, lido, &tsplib)) return false;
+
+   int N = tsplib.N;
+   int *peso = N <= CAIXEIRO_MAX_CIDADES ? matriz_destino(buffer, N) : NULL;
+
+   if(peso != NULL) tsplib_matriz(&tsplib, peso);
+   tsplib_liberar(&tsplib);
+
+   if(peso == NULL) return false;
+
+   instancia->N = N;
+   instancia->origem = 0;
+   instancia->peso = peso;
+   return true;
+}
+
+static bool ler(FILE *entrada, INSTANCIA *instancia, int *buffer){
+   int c;
+
+   instancia->peso = NULL;
+
+   //pulo espaços entre instâncias e olho o primeiro byte sem consumi-lo
+   do{
+      c = getc(entrada);
+   }while(c == ' ' || c == '\n' || c == '\r' || c == '\t');
+
+   if(c == EOF) return false;
+   ungetc(c, entrada);
+
+   if(!isalpha(c)) return instancia_ler_texto(entrada, instancia, buffer);
+
+   //começa com letra: binário ("CXB1") ou um cabeçalho TSPLIB ("NAME: ...")
+   char lido[5] = {0};
+   size_t n = fread(lido, 1, 4, entrada);
+
+   if(n == 4 && memcmp(lido, "CXB1", 4) == 0) return instancia_ler_binario(entrada, instancia, buffer);
+   return instancia_ler_tsplib(entrada, lido, instancia, buffer);
+}
+
+bool instancia_ler(FILE *entrada, INSTANCIA *instancia){
+   return ler(entrada, instancia, NULL);
+}
+
+bool instancia_ler_em(FILE *entrada, INSTANCIA *instancia, int *peso){
+   return ler(entrada, instancia, peso);
+}
+
+void instancia_liberar(INSTANCIA *instancia){
+   if(instancia == NULL) return;
+
+   free(instancia->peso);
+   instancia->peso = NULL;
+   instancia->N = 0;
+}
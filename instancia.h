@@ -0,0 +1,35 @@
+#ifndef INSTANCIA_H
+    #define INSTANCIA_H
+
+    #include<stdio.h>
+    #include<stdbool.h>
+
+    /*
+    Instância do caixeiro viajante em matriz densa: peso[i*N + j] é a aresta
+    i -> j, ou SEM_LIGACAO (caixeiro.h) se não existe. Origem em base zero.
+
+    Formatos aceitos por instancia_ler, detectados pelo primeiro byte:
+       texto:   "cidades origem ligacoes" seguido de "a b peso" por ligação,
+                cidades em base 1 e arestas nos dois sentidos (o mesmo de main.c);
+                como em main.c, vale o último peso de uma aresta repetida
+       binário: os 4 bytes "CXB1", depois int32 N, int32 origem (base zero) e
+                N*N int32 com a matriz, tudo na ordem de bytes da máquina
+       TSPLIB:  qualquer outra entrada que comece com letra (ver tsplib.h),
+                origem na cidade 1; a matriz vem direto das coordenadas
+    */
+    typedef struct {
+        int N;
+        int origem;
+        int *peso;
+    } INSTANCIA;
+
+    // Lê a próxima instância do fluxo. Retorna false no fim do arquivo ou se a entrada for inválida.
+    bool instancia_ler(FILE *entrada, INSTANCIA *instancia);
+    void instancia_liberar(INSTANCIA *instancia);
+
+    // Como instancia_ler, mas a matriz vai para `peso`, com espaço para
+    // CAIXEIRO_MAX_CIDADES^2 inteiros, e nada é alocado para ela; não chame
+    // instancia_liberar numa instância lida assim.
+    bool instancia_ler_em(FILE *entrada, INSTANCIA *instancia, int *peso);
+
+#endif
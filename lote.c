@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lote.h"
+#include "caixeiro.h"
+#include "instancia.h"
+#include "trabalhadores.h"
+
+#include<stdlib.h>
+#include<pthread.h>
+
+typedef struct lote LOTE;
+
+typedef struct {
+   INSTANCIA instancia;
+   CAIXEIRO_RESULTADO resultado;
+   bool pronto;
+   LOTE *lote;
+   int peso[CAIXEIRO_MAX_CIDADES * CAIXEIRO_MAX_CIDADES];
+} PEDIDO;
+
+/*
+Anel de `capacidade` pedidos: o da instância i fica em i % capacidade e só
+é reaproveitado depois que a resposta da instância i - capacidade saiu.
+*/
+struct lote{
+   PEDIDO *pedidos;
+   int capacidade;
+   int opcoes;
+
+   pthread_mutex_t trava;
+   pthread_cond_t pronto;
+};
+
+static void resolver_pedido(void *tarefa, CAIXEIRO_AREA *area){
+   PEDIDO *pedido = (PEDIDO*) tarefa;
+   LOTE *lote = pedido->lote;
+
+   caixeiro_resolver_matriz(area, pedido->instancia.peso, pedido->instancia.origem, pedido->instancia.N,
+                            lote->opcoes, &pedido->resultado);
+
+   pthread_mutex_lock(&lote->trava);
+   pedido->pronto = true;
+   pthread_cond_broadcast(&lote->pronto);
+   pthread_mutex_unlock(&lote->trava);
+}
+
+//escreve as respostas prontas a partir de *escritos; com `esperar`, bloqueia até sair a de `ate` - 1
+static void escrever_prontos(LOTE *lote, FILE *saida, long *escritos, long ate, bool esperar){
+   while(*escritos < ate){
+      PEDIDO *pedido = &lote->pedidos[*escritos % lote->capacidade];
+
+      pthread_mutex_lock(&lote->trava);
+      while(esperar && !pedido->pronto) pthread_cond_wait(&lote->pronto, &lote->trava);
+      bool pronto = pedido->pronto;
+      pthread_mutex_unlock(&lote->trava);
+
+      if(!pronto) return;
+
+      caixeiro_escrever(saida, &pedido->resultado);
+      (*escritos)++;
+   }
+}
+
+int lote_executar(FILE *entrada, FILE *saida, int threads, int fila, int opcoes){
+   if(threads <= 0 || fila <= 0) return 1;
+
+   LOTE lote;
+   lote.capacidade = fila;
+   lote.opcoes = opcoes;
+   lote.pedidos = (PEDIDO*) malloc(fila * sizeof(PEDIDO));
+   if(lote.pedidos == NULL) return 1;
+
+   pthread_mutex_init(&lote.trava, NULL);
+   pthread_cond_init(&lote.pronto, NULL);
+
+   TRABALHADORES *trabalhadores = trabalhadores_criar(threads, fila, resolver_pedido);
+   long lidos = 0, escritos = 0;
+   int retorno = trabalhadores == NULL;
+
+   while(trabalhadores != NULL){
+      //vaga no anel: a resposta mais antiga precisa ter saído
+      if(lidos - escritos == lote.capacidade) escrever_prontos(&lote, saida, &escritos, escritos + 1, true);
+
+      PEDIDO *pedido = &lote.pedidos[lidos % lote.capacidade];
+      pedido->lote = &lote;
+      pedido->pronto = false;
+
+      if(!instancia_ler_em(entrada, &pedido->instancia, pedido->peso)){
+         //fim normal do fluxo: nada a responder
+         if(feof(entrada) && !ferror(entrada)) break;
+
+         escrever_prontos(&lote, saida, &escritos, lidos, true);
+         fputs("ERRO\n", saida);
+         retorno = 1;
+         break;
+      }
+
+      lidos++;
+      if(!trabalhadores_enviar(trabalhadores, pedido)){
+         pedido->resultado.status = CAIXEIRO_SEM_MEMORIA;
+         pedido->resultado.tamanho = 0;
+         pedido->pronto = true;
+         retorno = 1;
+         break;
+      }
+
+      escrever_prontos(&lote, saida, &escritos, lidos, false);
+   }
+
+   if(trabalhadores != NULL) escrever_prontos(&lote, saida, &escritos, lidos, true);
+   trabalhadores_apagar(&trabalhadores);
+
+   pthread_mutex_destroy(&lote.trava);
+   pthread_cond_destroy(&lote.pronto);
+   free(lote.pedidos);
+   fflush(saida);
+   return retorno;
+}
@@ -0,0 +1,18 @@
+#ifndef LOTE_H
+    #define LOTE_H
+
+    #include<stdio.h>
+
+    /*
+    Modo lote: lê instâncias concatenadas de `entrada` (texto, binário ou
+    TSPLIB, ver instancia.h), resolve em `threads` trabalhadores e escreve
+    uma linha por instância em `saida`, na ordem da entrada, no formato de
+    caixeiro_escrever. Uma entrada ilegível vira "ERRO" e encerra a leitura.
+
+    Até `fila` instâncias ficam em voo ao mesmo tempo, cada uma num espaço
+    fixo alocado uma vez; junto com as áreas das threads, nada é alocado por
+    instância. Retorna 0, ou 1 se houve ERRO ou falta de memória.
+    */
+    int lote_executar(FILE *entrada, FILE *saida, int threads, int fila, int opcoes);
+
+#endif
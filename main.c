@@ -1,15 +1,158 @@
 #include "Grafo.h"
+#include "caixeiro.h"
+#include "servidor.h"
+#include "lote.h"
+#include "trabalhadores.h"
+#include "instancia.h"
+#include "tsplib.h"
 
 #include<stdio.h>
 #include<stdlib.h>
+#include<string.h>
+#include<inttypes.h>
 
 
 GRAFO **alocar_vetor_grafo(int n);
 
-int main(){
+static int distancia_tsplib(const void *ctx, int a, int b){
+    return tsplib_distancia((const TSPLIB*) ctx, a, b);
+}
+
+// --janela: instância TSPLIB de qualquer tamanho, vizinho mais próximo e depois caixeiro_melhorar.
+static int melhorar_tsplib(const TSPLIB *instancia, int k){
+    int N = instancia->N;
+    int *rota = (int*) malloc(N * sizeof(int));
+    CAIXEIRO_AREA *area = caixeiro_area_criar();
+    uint64_t inicial = 0, custo = 0;
+    CAIXEIRO_STATUS status = CAIXEIRO_SEM_MEMORIA;
+
+    if(rota != NULL && area != NULL && tsplib_rota_gulosa(instancia, rota)){
+        for(int i = 0; i < N; i++) inicial += distancia_tsplib(instancia, rota[i], rota[(i + 1) % N]);
+        status = caixeiro_melhorar(area, rota, N, k, distancia_tsplib, instancia, &custo);
+    }
+
+    switch(status){
+        case CAIXEIRO_OK:
+            printf("Custo inicial: %" PRIu64 "\n", inicial);
+            printf("Rota: %d", rota[0] + 1);
+            for(int i = 1; i < N; i++) printf(" - %d", rota[i] + 1);
+            printf(" - %d\n", rota[0] + 1);
+            printf("Custo final: %" PRIu64 "\n", custo);
+            break;
+        case CAIXEIRO_SEM_MEMORIA:
+            printf("Memoria insuficiente\n");
+            break;
+        default:
+            printf("Entrada invalida\n");
+            break;
+    }
+
+    caixeiro_area_apagar(&area);
+    free(rota);
+    return status == CAIXEIRO_OK ? 0 : 1;
+}
+
+// --tsplib: matriz calculada das coordenadas, nada de listas para as N^2 arestas.
+static int resolver_tsplib(const TSPLIB *instancia, int opcoes, bool so_existencia,
+                           bool automatico, const CAIXEIRO_LIMITES *limites){
+    int N = instancia->N;
+    CAIXEIRO_AREA *area = caixeiro_area_criar();
+    CAIXEIRO_ESCOLHA escolha;
+    CAIXEIRO_RESULTADO resultado;
+    int retorno = 0;
+
+    if(N > CAIXEIRO_MAX_CIDADES && !so_existencia && automatico &&
+       caixeiro_escolher(area, NULL, N, limites, &escolha, stderr) == CAIXEIRO_OK){
+        caixeiro_area_apagar(&area);
+        return melhorar_tsplib(instancia, CAIXEIRO_JANELA_PADRAO);
+    }
+
+    int *peso = N <= CAIXEIRO_MAX_CIDADES ? (int*) malloc((size_t)N * N * sizeof(int)) : NULL;
+
+    if(peso == NULL){
+        fprintf(stderr, "Instancia com mais de %d cidades: use --janela k ou --auto\n", CAIXEIRO_MAX_CIDADES);
+        retorno = 1;
+    }
+    else{
+        tsplib_matriz(instancia, peso);
+
+        if(so_existencia){
+            if(caixeiro_existe_rota_matriz(area, peso, N) == CAIXEIRO_OK) printf("Existe rota\n");
+            else printf("Nao existe rota\n");
+        }
+        else{
+            if(automatico) caixeiro_resolver_auto_matriz(area, peso, 0, N, limites, stderr, &resultado);
+            else caixeiro_resolver_matriz(area, peso, 0, N, opcoes, &resultado);
+            caixeiro_imprimir(&resultado, 0);
+        }
+    }
+
+    free(peso);
+    caixeiro_area_apagar(&area);
+    return retorno;
+}
+
+int main(int argc, char *argv[]){
     // Numero de nos, começo da viagem, e ligações entre os nos.
     int cidades, origem, ligacoes;
 
+    // Opções da dp passadas na linha de comando.
+    int opcoes = 0;
+    bool so_existencia = false;
+    // Entrada no formato TSPLIB em vez das ligações "a b peso".
+    bool tsplib = false;
+    // Tamanho da janela de --janela (0: resolve exato).
+    int janela = 0;
+    // --auto: o seletor escolhe o motor dentro de --memoria (MB) e --tempo (s).
+    bool automatico = false;
+    CAIXEIRO_LIMITES limites = {0, 0};
+    // Modo servidor: socket, threads e tamanho da fila.
+    const char *servidor = NULL;
+    // Modo lote: várias instâncias da entrada padrão nas mesmas threads.
+    bool lote = false;
+    int threads = trabalhadores_processadores(), fila = 64;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--camadas") == 0) opcoes |= MC_CAMADAS;
+        else if(strcmp(argv[i], "--poda") == 0) opcoes |= MC_PODA;
+        else if(strcmp(argv[i], "--meio") == 0) opcoes |= MC_MEIO;
+        else if(strcmp(argv[i], "--existe") == 0) so_existencia = true;
+        else if(strcmp(argv[i], "--tsplib") == 0) tsplib = true;
+        else if(strcmp(argv[i], "--janela") == 0 && i + 1 < argc) janela = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--auto") == 0) automatico = true;
+        else if(strcmp(argv[i], "--memoria") == 0 && i + 1 < argc) limites.memoria = (size_t) atoi(argv[++i]) << 20;
+        else if(strcmp(argv[i], "--tempo") == 0 && i + 1 < argc) limites.segundos = atof(argv[++i]);
+        else if(strcmp(argv[i], "--servidor") == 0 && i + 1 < argc) servidor = argv[++i];
+        else if(strcmp(argv[i], "--lote") == 0) lote = true;
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--fila") == 0 && i + 1 < argc) fila = atoi(argv[++i]);
+        else{
+            fprintf(stderr, "Uso: %s [--camadas] [--poda] [--meio] [--existe] [--tsplib] [--janela k] [--auto [--memoria MB] [--tempo s]] [--servidor socket | --lote [--threads n] [--fila n]] < entrada\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(servidor != NULL){
+        if(servidor_executar(servidor, threads, fila, opcoes) == 0) return 0;
+        fprintf(stderr, "Nao foi possivel escutar em %s\n", servidor);
+        return 1;
+    }
+
+    if(lote) return lote_executar(stdin, stdout, threads, fila, opcoes);
+
+    if(janela > 0 || tsplib){
+        TSPLIB instancia;
+
+        if(!tsplib_ler(stdin, NULL, &instancia)){
+            fprintf(stderr, "Entrada TSPLIB invalida\n");
+            return 1;
+        }
+
+        int retorno = janela > 0 ? melhorar_tsplib(&instancia, janela)
+                                 : resolver_tsplib(&instancia, opcoes, so_existencia, automatico, &limites);
+        tsplib_liberar(&instancia);
+        return retorno;
+    }
 
     scanf("%d %d %d", &cidades, &origem, &ligacoes);
     origem--; // Base zero.
@@ -22,12 +165,30 @@ int main(){
         int cidade_a, cidade_b, peso;
         scanf("%d %d %d", &cidade_a, &cidade_b, &peso);
         cidade_a--; cidade_b--; // Base 0.
-        grafo_inserir(distancia[cidade_a], cidade_b, peso);
-        grafo_inserir(distancia[cidade_b], cidade_a, peso);
+        // Uma ligação repetida fica com o último peso lido.
+        grafo_inserir_ou_atualizar(distancia[cidade_a], cidade_b, peso);
+        grafo_inserir_ou_atualizar(distancia[cidade_b], cidade_a, peso);
     }
     
     
-    menor_caminho(distancia, origem, cidades);
+    if(so_existencia){
+        CAIXEIRO_AREA *area = caixeiro_area_criar();
+
+        if(caixeiro_existe_rota(area, distancia, cidades) == CAIXEIRO_OK) printf("Existe rota\n");
+        else printf("Nao existe rota\n");
+
+        caixeiro_area_apagar(&area);
+    }
+    else if(automatico){
+        CAIXEIRO_AREA *area = caixeiro_area_criar();
+        CAIXEIRO_RESULTADO resultado;
+
+        caixeiro_resolver_auto(area, distancia, origem, cidades, &limites, stderr, &resultado);
+        caixeiro_imprimir(&resultado, origem);
+
+        caixeiro_area_apagar(&area);
+    }
+    else menor_caminho_opcoes(distancia, origem, cidades, opcoes);
     
     // Desalocação de memoria
     for(int i = 0; i < cidades; i++){
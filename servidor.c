@@ -0,0 +1,314 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "servidor.h"
+#include "caixeiro.h"
+#include "instancia.h"
+#include "trabalhadores.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<signal.h>
+#include<pthread.h>
+#include<unistd.h>
+#include<sys/select.h>
+#include<sys/socket.h>
+#include<sys/un.h>
+
+typedef struct conexao CONEXAO;
+typedef struct pedido PEDIDO;
+typedef struct abertas ABERTAS;
+
+/*Posto pelo tratador de SIGINT/SIGTERM; o laço do accept para quando vê*/
+static volatile sig_atomic_t parar;
+
+static void pedir_parada(int sinal){
+   (void) sinal;
+   parar = 1;
+}
+
+struct pedido{
+   INSTANCIA instancia;
+   CAIXEIRO_RESULTADO resultado;
+   bool legivel;     //false: marca de erro de leitura, vai como "ERRO"
+   bool pronto;
+   CONEXAO *conexao;
+   PEDIDO *proximo;
+};
+
+/*Pedidos de uma conexão, na ordem em que chegaram*/
+struct conexao{
+   int fd;
+   int opcoes;
+   int limite;          //máximo de pedidos pendentes nesta conexão
+   TRABALHADORES *trabalhadores;
+
+   pthread_mutex_t trava;
+   pthread_cond_t mudou;
+   PEDIDO *inicio;
+   PEDIDO *fim;
+   int pendentes;
+   bool terminou;       //o leitor não vai mais enfileirar nada
+
+   ABERTAS *abertas;
+   CONEXAO *anterior, *seguinte;
+};
+
+/*Conexões com leitor vivo, para o servidor fechar a leitura delas ao parar*/
+struct abertas{
+   pthread_mutex_t trava;
+   pthread_cond_t saiu;
+   CONEXAO *lista;
+};
+
+static void resolver_pedido(void *tarefa, CAIXEIRO_AREA *area){
+   PEDIDO *pedido = (PEDIDO*) tarefa;
+   CONEXAO *conexao = pedido->conexao;
+
+   caixeiro_resolver_matriz(area, pedido->instancia.peso, pedido->instancia.origem, pedido->instancia.N,
+                            conexao->opcoes, &pedido->resultado);
+
+   pthread_mutex_lock(&conexao->trava);
+   pedido->pronto = true;
+   pthread_cond_broadcast(&conexao->mudou);
+   pthread_mutex_unlock(&conexao->trava);
+}
+
+static void escrever_resposta(FILE *saida, const PEDIDO *pedido){
+   if(!pedido->legivel){
+      fputs("ERRO\n", saida);
+      return;
+   }
+
+   caixeiro_escrever(saida, &pedido->resultado);
+}
+
+/*Responde os pedidos em ordem, esperando cada um ficar pronto*/
+static void *escritor(void *arg){
+   CONEXAO *conexao = (CONEXAO*) arg;
+   FILE *saida = fdopen(dup(conexao->fd), "w");
+
+   while(1){
+      pthread_mutex_lock(&conexao->trava);
+      while(!(conexao->inicio != NULL && conexao->inicio->pronto) && !(conexao->terminou && conexao->inicio == NULL))
+         pthread_cond_wait(&conexao->mudou, &conexao->trava);
+
+      PEDIDO *pedido = conexao->inicio;
+      if(pedido == NULL){
+         pthread_mutex_unlock(&conexao->trava);
+         break;
+      }
+
+      conexao->inicio = pedido->proximo;
+      if(conexao->inicio == NULL) conexao->fim = NULL;
+      conexao->pendentes--;
+      bool mais_prontos = conexao->inicio != NULL && conexao->inicio->pronto;
+
+      pthread_cond_broadcast(&conexao->mudou);
+      pthread_mutex_unlock(&conexao->trava);
+
+      if(saida != NULL){
+         escrever_resposta(saida, pedido);
+         if(!mais_prontos) fflush(saida); //junto respostas já prontas numa escrita só
+      }
+
+      instancia_liberar(&pedido->instancia);
+      free(pedido);
+   }
+
+   if(saida != NULL) fclose(saida);
+   return NULL;
+}
+
+static void enfileirar(CONEXAO *conexao, PEDIDO *pedido){
+   pthread_mutex_lock(&conexao->trava);
+   while(conexao->pendentes >= conexao->limite) pthread_cond_wait(&conexao->mudou, &conexao->trava);
+
+   if(conexao->fim != NULL) conexao->fim->proximo = pedido;
+   else conexao->inicio = pedido;
+   conexao->fim = pedido;
+   conexao->pendentes++;
+
+   if(!pedido->legivel){
+      pedido->pronto = true;
+      pthread_cond_broadcast(&conexao->mudou);
+   }
+   pthread_mutex_unlock(&conexao->trava);
+}
+
+/*Lê instâncias da conexão até o cliente fechar ou mandar algo ilegível*/
+static void *leitor(void *arg){
+   CONEXAO *conexao = (CONEXAO*) arg;
+   FILE *entrada = fdopen(conexao->fd, "r");
+   pthread_t thread_escritor;
+   bool tem_escritor = entrada != NULL && pthread_create(&thread_escritor, NULL, escritor, conexao) == 0;
+
+   while(tem_escritor){
+      PEDIDO *pedido = (PEDIDO*) calloc(1, sizeof(PEDIDO));
+      if(pedido == NULL) break;
+
+      pedido->conexao = conexao;
+      pedido->legivel = instancia_ler(entrada, &pedido->instancia);
+
+      if(!pedido->legivel){
+         //fim normal do fluxo: nada a responder
+         if(feof(entrada) && !ferror(entrada)){
+            free(pedido);
+            break;
+         }
+         enfileirar(conexao, pedido);
+         break;
+      }
+
+      enfileirar(conexao, pedido);
+      if(!trabalhadores_enviar(conexao->trabalhadores, pedido)){
+         pthread_mutex_lock(&conexao->trava);
+         pedido->resultado.status = CAIXEIRO_SEM_MEMORIA;
+         pedido->pronto = true;
+         pthread_cond_broadcast(&conexao->mudou);
+         pthread_mutex_unlock(&conexao->trava);
+         break;
+      }
+   }
+
+   pthread_mutex_lock(&conexao->trava);
+   conexao->terminou = true;
+   pthread_cond_broadcast(&conexao->mudou);
+   pthread_mutex_unlock(&conexao->trava);
+
+   if(tem_escritor) pthread_join(thread_escritor, NULL);
+
+   //sai da lista antes de fechar o fd, para o servidor não mexer num fd reaproveitado
+   ABERTAS *abertas = conexao->abertas;
+   pthread_mutex_lock(&abertas->trava);
+   if(conexao->anterior != NULL) conexao->anterior->seguinte = conexao->seguinte;
+   else abertas->lista = conexao->seguinte;
+   if(conexao->seguinte != NULL) conexao->seguinte->anterior = conexao->anterior;
+   pthread_cond_broadcast(&abertas->saiu);
+   pthread_mutex_unlock(&abertas->trava);
+
+   if(entrada != NULL) fclose(entrada);
+   else close(conexao->fd);
+
+   pthread_mutex_destroy(&conexao->trava);
+   pthread_cond_destroy(&conexao->mudou);
+   free(conexao);
+   return NULL;
+}
+
+int servidor_executar(const char *caminho, int threads, int fila, int opcoes){
+   struct sockaddr_un endereco;
+   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+   if(fd < 0 || strlen(caminho) >= sizeof(endereco.sun_path)){
+      if(fd >= 0) close(fd);
+      return 1;
+   }
+
+   memset(&endereco, 0, sizeof(endereco));
+   endereco.sun_family = AF_UNIX;
+   strcpy(endereco.sun_path, caminho);
+   unlink(caminho);
+
+   if(bind(fd, (struct sockaddr*) &endereco, sizeof(endereco)) != 0 || listen(fd, 64) != 0){
+      close(fd);
+      return 1;
+   }
+
+   //um cliente que fecha antes da resposta não pode derrubar o processo
+   signal(SIGPIPE, SIG_IGN);
+
+   /*
+   SIGINT/SIGTERM ficam bloqueados em todas as threads (as criadas aqui
+   herdam a máscara) e só são aceitos dentro do pselect, que troca a máscara
+   atomicamente: um sinal entre o teste de `parar` e a espera não se perde.
+   */
+   struct sigaction tratador, antigo_int, antigo_term;
+   sigset_t bloquear, mascara_original;
+
+   memset(&tratador, 0, sizeof(tratador));
+   tratador.sa_handler = pedir_parada;
+   sigemptyset(&tratador.sa_mask);
+   sigemptyset(&bloquear);
+   sigaddset(&bloquear, SIGINT);
+   sigaddset(&bloquear, SIGTERM);
+
+   parar = 0;
+   pthread_sigmask(SIG_BLOCK, &bloquear, &mascara_original);
+   sigaction(SIGINT, &tratador, &antigo_int);
+   sigaction(SIGTERM, &tratador, &antigo_term);
+
+   sigset_t esperando = mascara_original;
+   sigdelset(&esperando, SIGINT);
+   sigdelset(&esperando, SIGTERM);
+
+   ABERTAS abertas;
+   pthread_mutex_init(&abertas.trava, NULL);
+   pthread_cond_init(&abertas.saiu, NULL);
+   abertas.lista = NULL;
+
+   TRABALHADORES *trabalhadores = trabalhadores_criar(threads, fila, resolver_pedido);
+   int retorno = trabalhadores != NULL ? 0 : 1;
+
+   while(trabalhadores != NULL && !parar){
+      fd_set prontos;
+      FD_ZERO(&prontos);
+      FD_SET(fd, &prontos);
+      if(pselect(fd + 1, &prontos, NULL, NULL, NULL, &esperando) <= 0) continue; //EINTR: volta a olhar `parar`
+
+      int cliente = accept(fd, NULL, NULL);
+      if(cliente < 0) continue;
+
+      CONEXAO *conexao = (CONEXAO*) calloc(1, sizeof(CONEXAO));
+      pthread_t thread;
+
+      if(conexao == NULL){
+         close(cliente);
+         continue;
+      }
+      conexao->fd = cliente;
+      conexao->opcoes = opcoes;
+      conexao->limite = fila;
+      conexao->trabalhadores = trabalhadores;
+      conexao->abertas = &abertas;
+      pthread_mutex_init(&conexao->trava, NULL);
+      pthread_cond_init(&conexao->mudou, NULL);
+
+      pthread_mutex_lock(&abertas.trava);
+      conexao->seguinte = abertas.lista;
+      if(abertas.lista != NULL) abertas.lista->anterior = conexao;
+      abertas.lista = conexao;
+
+      if(pthread_create(&thread, NULL, leitor, conexao) != 0){
+         abertas.lista = conexao->seguinte;
+         if(abertas.lista != NULL) abertas.lista->anterior = NULL;
+         pthread_mutex_unlock(&abertas.trava);
+         pthread_mutex_destroy(&conexao->trava);
+         pthread_cond_destroy(&conexao->mudou);
+         free(conexao);
+         close(cliente);
+         continue;
+      }
+      pthread_mutex_unlock(&abertas.trava);
+      pthread_detach(thread);
+   }
+
+   close(fd);
+   unlink(caminho);
+
+   //os leitores veem fim de arquivo, e cada conexão responde o que já leu antes de fechar
+   pthread_mutex_lock(&abertas.trava);
+   for(CONEXAO *conexao = abertas.lista; conexao != NULL; conexao = conexao->seguinte)
+      shutdown(conexao->fd, SHUT_RD);
+   while(abertas.lista != NULL) pthread_cond_wait(&abertas.saiu, &abertas.trava);
+   pthread_mutex_unlock(&abertas.trava);
+
+   if(trabalhadores != NULL) trabalhadores_apagar(&trabalhadores);
+   pthread_mutex_destroy(&abertas.trava);
+   pthread_cond_destroy(&abertas.saiu);
+
+   sigaction(SIGINT, &antigo_int, NULL);
+   sigaction(SIGTERM, &antigo_term, NULL);
+   pthread_sigmask(SIG_SETMASK, &mascara_original, NULL);
+   return retorno;
+}
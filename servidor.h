@@ -0,0 +1,22 @@
+#ifndef SERVIDOR_H
+    #define SERVIDOR_H
+
+    /*
+    Modo servidor: escuta num socket Unix local em `caminho` e resolve as
+    instâncias (texto ou binário, ver instancia.h) que chegam em cada conexão.
+    Uma conexão pode mandar várias instâncias sem esperar as respostas; elas
+    são resolvidas em paralelo e respondidas na ordem de chegada, uma linha
+    por instância:
+       OK <custo> <cidade> ... <cidade>   (rota em base 1, começa e termina na origem)
+       SEM_ROTA | SEM_MEMORIA | INVALIDA  (status do solver)
+       ERRO                               (entrada ilegível; a conexão é encerrada)
+
+    `threads` trabalhadores mantêm suas áreas da dp entre pedidos; `fila`
+    limita os pedidos em espera, e quem envia demais fica bloqueado até
+    surgir vaga. SIGINT ou SIGTERM param de aceitar conexões: as abertas
+    respondem o que já mandaram, o arquivo do socket é removido e retorna 0.
+    Retorna 1 se não conseguir abrir o socket ou criar os trabalhadores.
+    */
+    int servidor_executar(const char *caminho, int threads, int fila, int opcoes);
+
+#endif
@@ -1,6 +1,11 @@
 #include <stdio.h>
+#include <pthread.h>
 
 #include "avl.h"
+#include "pool.h"
+
+//altura minima de uma subarvore para que valha a pena criar uma thread
+#define AVL_PARALLEL_HEIGHT 14
 
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 #define UPDATE_HEIGHT(x)                                                                 \
@@ -8,19 +13,6 @@
         (x)->height = MAX(avl_height((x)->left), avl_height((x)->right)) + 1;            \
     } while (0)
 
-//node da arvore
-typedef struct avl_node {
-    //valor armazenado no node
-    int value;
-
-    //altura no node, usado para balanceamento
-    int height;
-
-    //ponteiros para seus filhos esq e dir
-    struct avl_node *left;
-    struct avl_node *right;
-} AVL_NODE;
-
 
 //estrutura para dividir a AVL em duas partes
 typedef struct avl_split {
@@ -51,14 +43,15 @@ struct avl_tree {
 
     //numero de nos dessa arvore
     size_t len;
-};
 
-void avl_free_impl(AVL_NODE *);
+    //slabs de onde saem os nodes dessa arvore, compartilhados com suas copias
+    POOL *pool;
+};
 
 /*
 criar uma arvore AVL vazia
 Inicializando sua raiz como NULL
-e seu tamanho como zero
+e seu tamanho como zero, com um pool de nodes proprio
 */
 AVL_TREE *avl_tree_new(void)
 {
@@ -66,6 +59,7 @@ AVL_TREE *avl_tree_new(void)
 
     tree->root = NULL;
     tree->len = 0;
+    tree->pool = pool_new(sizeof(AVL_NODE));
 
     return tree;
 }
@@ -73,11 +67,11 @@ AVL_TREE *avl_tree_new(void)
 /*
 criar um novo node na AVL com o valor fornecido
 incializando os ponteiros dos filhos para NULL
-e sua altura como 0
+e sua altura como 0, com uma unica referencia. O node vem do pool da arvore
 */
-static AVL_NODE *avl_node_new(int value)
+static AVL_NODE *avl_node_new(POOL *pool, int value)
 {
-    AVL_NODE *node = malloc(sizeof *node);
+    AVL_NODE *node = pool_alloc(pool);
 
     node->value = value;
 
@@ -85,6 +79,7 @@ static AVL_NODE *avl_node_new(int value)
     node->right = NULL;
 
     node->height = 0;
+    node->refs = 1;
 
     return node;
 }
@@ -103,6 +98,118 @@ static int avl_height(AVL_NODE *node)
 }
 
 
+/////REFERENCIAS E COPY-ON-WRITE/////
+
+/*
+As versões de uma arvore (avl_tree_clone) compartilham os nodes que nenhuma
+delas modificou. Toda função que recebe um AVL_NODE * fica com a referencia
+passada: ou ela passa a fazer parte do resultado, ou e solta com avl_unref().
+Antes de modificar um node, avl_own() garante que so quem modifica o enxerga
+*/
+
+//mais uma referencia para o node
+static AVL_NODE *avl_ref(AVL_NODE *node)
+{
+    if (node)
+        node->refs++;
+
+    return node;
+}
+
+/*
+Solta uma referencia para a subarvore: se era a ultima, o node volta para
+o pool e solta as referencias que tinha para os filhos
+*/
+static void avl_unref(POOL *pool, AVL_NODE *root)
+{
+    if (!root || --root->refs > 0)
+        return;
+
+    avl_unref(pool, root->left);
+    avl_unref(pool, root->right);
+
+    pool_release(pool, root);
+}
+
+/*
+Retorna um node que pode ser modificado no lugar de node: ele mesmo, se
+ninguem mais o enxerga, ou uma copia que divide os filhos com ele
+*/
+static AVL_NODE *avl_own(POOL *pool, AVL_NODE *node)
+{
+    if (node->refs == 1)
+        return node;
+
+    AVL_NODE *copy = avl_node_new(pool, node->value);
+
+    copy->height = node->height;
+    copy->left = avl_ref(node->left);
+    copy->right = avl_ref(node->right);
+
+    node->refs--;
+
+    return copy;
+}
+
+/*
+Separa o node dos seus filhos e solta a referencia para ele, retornando
+seu valor. As referencias para os filhos passam para quem chamou
+*/
+static int avl_take(POOL *pool, AVL_NODE *node, AVL_NODE **left, AVL_NODE **right)
+{
+    int value = node->value;
+
+    if (node->refs == 1) {
+        *left = node->left;
+        *right = node->right;
+
+        pool_release(pool, node);
+    } else {
+        *left = avl_ref(node->left);
+        *right = avl_ref(node->right);
+
+        node->refs--;
+    }
+
+    return value;
+}
+
+/*
+Monta uma subarvore perfeitamente balanceada com os valores ordenados
+de vals: o elemento do meio vira a raiz e as metades os filhos, cujos
+tamanhos diferem no maximo em 1, entao o resultado ja e uma AVL
+*/
+static AVL_NODE *avl_build_impl(POOL *pool, const int *vals, size_t n)
+{
+    if (n == 0)
+        return NULL;
+
+    size_t mid = n / 2;
+    AVL_NODE *node = avl_node_new(pool, vals[mid]);
+
+    node->left = avl_build_impl(pool, vals, mid);
+    node->right = avl_build_impl(pool, vals + mid + 1, n - mid - 1);
+
+    UPDATE_HEIGHT(node);
+
+    return node;
+}
+
+/*
+cria uma arvore AVL a partir de valores em ordem estritamente
+crescente, em O(n), sem nenhuma rotação
+*/
+AVL_TREE *avl_tree_from_sorted(const int *vals, size_t n)
+{
+    AVL_TREE *tree = avl_tree_new();
+
+    tree->root = avl_build_impl(tree->pool, vals, n);
+    tree->len = n;
+
+    return tree;
+}
+
+
 /////FUNÇÕES DE ROTAÇÃO/////
 
 /*
@@ -110,11 +217,12 @@ Rotação simples para a esquerda:
 filho direito do node que está desbalanceado
 se torna o novo node raiz, trocando seu filho esquerdo
 com o seu pai que estava desbalanceado.
-Por fim, atualiza as alturas dos nos envolvidos
+Por fim, atualiza as alturas dos nos envolvidos.
+O node ja deve poder ser modificado; o filho que sobe e copiado se preciso
 */
-static AVL_NODE *avl_rotate_left(AVL_NODE *node)
+static AVL_NODE *avl_rotate_left(POOL *pool, AVL_NODE *node)
 {
-    AVL_NODE *right = node->right;
+    AVL_NODE *right = avl_own(pool, node->right);
 
     node->right = right->left;
     right->left = node;
@@ -132,9 +240,9 @@ node raiz, de forma parecida com a rotação
 esquerda simples.
 Por fim, atualiza as alturas
 */
-static AVL_NODE *avl_rotate_right(AVL_NODE *node)
+static AVL_NODE *avl_rotate_right(POOL *pool, AVL_NODE *node)
 {
-    AVL_NODE *left = node->left;
+    AVL_NODE *left = avl_own(pool, node->left);
 
     node->left = left->right;
     left->right = node;
@@ -152,10 +260,10 @@ Uma rotação simples para a esquerda primeiro
 seguido de uma rotação simples para a direita
 resolvendo o desbalanceamento no lado dirieto do node
 */
-static AVL_NODE *avl_rotate_left_right(AVL_NODE *node)
+static AVL_NODE *avl_rotate_left_right(POOL *pool, AVL_NODE *node)
 {
-    node->left = avl_rotate_left(node->left);
-    return avl_rotate_right(node);
+    node->left = avl_rotate_left(pool, avl_own(pool, node->left));
+    return avl_rotate_right(pool, node);
 }
 
 
@@ -165,10 +273,10 @@ Uma rotação simples para a direita primeiro
 seguido de uma rotação simples para a esquerda
 resolvendo o desbalanceamento no lado esquerdo do node
 */
-static AVL_NODE *avl_rotate_right_left(AVL_NODE *node)
+static AVL_NODE *avl_rotate_right_left(POOL *pool, AVL_NODE *node)
 {
-    node->right = avl_rotate_right(node->right);
-    return avl_rotate_left(node);
+    node->right = avl_rotate_right(pool, avl_own(pool, node->right));
+    return avl_rotate_left(pool, node);
 }
 
 /*
@@ -176,10 +284,12 @@ Junta duas árvores AVL com um valor intermediario k como node raiz
 depois chama duas funções auxiliares, avl_join_left() e avl_join_right()
 que vão garantir que a arvore resultante esteja balanceada, ajustando os nodes
 */
-static AVL_NODE *avl_join_right(AVL_NODE *left, int k, AVL_NODE *right)
+static AVL_NODE *avl_join_right(POOL *pool, AVL_NODE *left, int k, AVL_NODE *right)
 {
+    left = avl_own(pool, left);
+
     if (avl_height(left->right) <= avl_height(right) + 1) {
-        AVL_NODE *new = avl_node_new(k);
+        AVL_NODE *new = avl_node_new(pool, k);
 
         new->left = left->right;
         new->right = right;
@@ -189,19 +299,19 @@ static AVL_NODE *avl_join_right(AVL_NODE *left, int k, AVL_NODE *right)
         left->right = new;
 
         if (new->height > avl_height(left->left) + 1)
-            left = avl_rotate_right_left(left);
+            left = avl_rotate_right_left(pool, left);
         else
             UPDATE_HEIGHT(left);
 
         return left;
     }
 
-    AVL_NODE *new = avl_join_right(left->right, k, right);
+    AVL_NODE *new = avl_join_right(pool, left->right, k, right);
 
     left->right = new;
 
     if (new->height > avl_height(left->left) + 1)
-        left = avl_rotate_left(left);
+        left = avl_rotate_left(pool, left);
     else
         UPDATE_HEIGHT(left);
 
@@ -215,10 +325,12 @@ esquerdo, e o right como filho direito, esse node é anexado como filho
 esquerdo de right.
 Verifica o balancemanto e faz as devidas rotações
 */
-static AVL_NODE *avl_join_left(AVL_NODE *left, int k, AVL_NODE *right)
+static AVL_NODE *avl_join_left(POOL *pool, AVL_NODE *left, int k, AVL_NODE *right)
 {
+    right = avl_own(pool, right);
+
     if (avl_height(right->left) <= avl_height(left) + 1) {
-        AVL_NODE *new = avl_node_new(k);
+        AVL_NODE *new = avl_node_new(pool, k);
 
         new->left = left;
         new->right = right->left;
@@ -228,19 +340,19 @@ static AVL_NODE *avl_join_left(AVL_NODE *left, int k, AVL_NODE *right)
         right->left = new;
 
         if (new->height > avl_height(right->right) + 1)
-            right = avl_rotate_left_right(right);
+            right = avl_rotate_left_right(pool, right);
         else
             UPDATE_HEIGHT(right);
 
         return right;
     }
 
-    AVL_NODE *new = avl_join_left(left, k, right->left);
+    AVL_NODE *new = avl_join_left(pool, left, k, right->left);
 
     right->left = new;
 
     if (new->height > avl_height(right->right) + 1)
-        right = avl_rotate_right(right);
+        right = avl_rotate_right(pool, right);
     else
         UPDATE_HEIGHT(right);
 
@@ -251,17 +363,17 @@ static AVL_NODE *avl_join_left(AVL_NODE *left, int k, AVL_NODE *right)
 junta duas subarvores AVL com um valor intermediario k como raiz
 e garante que o resultando esteja balanceado
 */
-static AVL_NODE *avl_join(AVL_NODE *left, int k, AVL_NODE *right)
+static AVL_NODE *avl_join(POOL *pool, AVL_NODE *left, int k, AVL_NODE *right)
 {
     if (avl_height(left) > avl_height(right) + 1)
         //se lefr for mais alta
-        return avl_join_right(left, k, right);
+        return avl_join_right(pool, left, k, right);
 
     else if (avl_height(right) > avl_height(left) + 1)
         //se right for mais alta
-        return avl_join_left(left, k, right);
+        return avl_join_left(pool, left, k, right);
 
-    AVL_NODE *node = avl_node_new(k);
+    AVL_NODE *node = avl_node_new(pool, k);
 
     node->left = left;
     node->right = right;
@@ -276,31 +388,28 @@ Dividi a arvore em duas, Uma subávore esquerda com valores menores que k
 e outra subarvore direita com valores maiores que k e retorna se o valor k
 estava presente na árvore original
 */
-static AVL_SPLIT avl_split(AVL_NODE *root, int k)
+static AVL_SPLIT avl_split(POOL *pool, AVL_NODE *root, int k)
 {
     if (!root)
         return (AVL_SPLIT) { NULL, NULL, false };
 
-    if (k == root->value) {
-        AVL_SPLIT result = { root->left, root->right, true };
+    AVL_NODE *left, *right;
+    int value = avl_take(pool, root, &left, &right);
 
-        free(root);
-        return result;
-    }
+    if (k == value)
+        return (AVL_SPLIT) { left, right, true };
 
-    if (k < root->value) {
-        AVL_SPLIT result = avl_split(root->left, k);
+    if (k < value) {
+        AVL_SPLIT result = avl_split(pool, left, k);
 
-        result.right = avl_join(result.right, root->value, root->right);
+        result.right = avl_join(pool, result.right, value, right);
 
-        free(root);
         return result;
     } else {
-        AVL_SPLIT result = avl_split(root->right, k);
+        AVL_SPLIT result = avl_split(pool, right, k);
 
-        result.left = avl_join(root->left, root->value, result.left);
+        result.left = avl_join(pool, left, value, result.left);
 
-        free(root);
         return result;
     }
 }
@@ -308,18 +417,17 @@ static AVL_SPLIT avl_split(AVL_NODE *root, int k)
 
 //Remove e retorna o maior valor da árvore 
 //utilizado na operação join_no_key
-static AVL_SPLIT_LAST avl_split_last(AVL_NODE *root)
+static AVL_SPLIT_LAST avl_split_last(POOL *pool, AVL_NODE *root)
 {
-    if (!root->right) {
-        AVL_SPLIT_LAST result = { root->left, root->value };
+    AVL_NODE *left, *right;
+    int value = avl_take(pool, root, &left, &right);
 
-        free(root);
-        return result;
-    }
+    if (!right)
+        return (AVL_SPLIT_LAST) { left, value };
 
-    AVL_SPLIT_LAST last = avl_split_last(root->right);
+    AVL_SPLIT_LAST last = avl_split_last(pool, right);
 
-    last.root = avl_join(root->left, root->value, last.root);
+    last.root = avl_join(pool, left, value, last.root);
 
     return last;
 }
@@ -329,22 +437,75 @@ static AVL_SPLIT_LAST avl_split_last(AVL_NODE *root)
 Junta duas subarvores AVL, left e right sem valor intermediario
 utilizado em operações que um node intermediario não é necessario
 */
-static AVL_NODE *avl_join_no_key(AVL_NODE *left, AVL_NODE *right)
+static AVL_NODE *avl_join_no_key(POOL *pool, AVL_NODE *left, AVL_NODE *right)
 {
     if (!left)
         return right;
 
-    AVL_SPLIT_LAST last = avl_split_last(left);
+    AVL_SPLIT_LAST last = avl_split_last(pool, left);
 
-    return avl_join(last.root, last.value, right);
+    return avl_join(pool, last.root, last.value, right);
 }
 
 
 /*
 Realiaza a união de duas arvores AVL, utilizando a operação
-avl_split() para dividir e combinar de forma recursiva as árvores
+avl_split() para dividir e combinar de forma recursiva as árvores.
+Soma em common quantos valores estavam nas duas
+*/
+static AVL_NODE *avl_union(POOL *pool, AVL_NODE *left, AVL_NODE *right, size_t *common)
+{
+    if (!left)
+        return right;
+
+    if (!right)
+        return left;
+
+    //a raiz de right volta para o pool e e reaproveitada pelo join
+    AVL_NODE *right_left, *right_right;
+    int k = avl_take(pool, right, &right_left, &right_right);
+
+    AVL_SPLIT split = avl_split(pool, left, k);
+    AVL_NODE *union_left = avl_union(pool, split.left, right_left, common);
+    AVL_NODE *union_right = avl_union(pool, split.right, right_right, common);
+
+    *common += split.present;
+
+    return avl_join(pool, union_left, k, union_right);
+}
+
+/*
+Diferença de duas arvores AVL: retira de left os valores presentes em right,
+devolvendo os nodes de right ao pool. Soma em removed quantos sairam de left
 */
-static AVL_NODE *avl_union(AVL_NODE *left, AVL_NODE *right)
+static AVL_NODE *avl_difference(POOL *pool, AVL_NODE *left, AVL_NODE *right, size_t *removed)
+{
+    if (!right)
+        return left;
+
+    if (!left) {
+        avl_unref(pool, right);
+        return NULL;
+    }
+
+    AVL_NODE *right_left, *right_right;
+    int k = avl_take(pool, right, &right_left, &right_right);
+
+    AVL_SPLIT split = avl_split(pool, left, k);
+
+    AVL_NODE *diff_left = avl_difference(pool, split.left, right_left, removed);
+    AVL_NODE *diff_right = avl_difference(pool, split.right, right_right, removed);
+
+    *removed += split.present;
+
+    return avl_join_no_key(pool, diff_left, diff_right);
+}
+
+/*
+Diferença simetrica de duas arvores AVL: fica com os valores que estão
+em apenas uma delas. Soma em common quantos estavam nas duas
+*/
+static AVL_NODE *avl_symmetric_difference(POOL *pool, AVL_NODE *left, AVL_NODE *right, size_t *common)
 {
     if (!left)
         return right;
@@ -352,60 +513,76 @@ static AVL_NODE *avl_union(AVL_NODE *left, AVL_NODE *right)
     if (!right)
         return left;
 
-    AVL_SPLIT split = avl_split(left, right->value);
-    AVL_NODE *union_left = avl_union(split.left, right->left);
-    AVL_NODE *union_right = avl_union(split.right, right->right);
+    AVL_NODE *right_left, *right_right;
+    int k = avl_take(pool, right, &right_left, &right_right);
+
+    AVL_SPLIT split = avl_split(pool, left, k);
+    AVL_NODE *sym_left = avl_symmetric_difference(pool, split.left, right_left, common);
+    AVL_NODE *sym_right = avl_symmetric_difference(pool, split.right, right_right, common);
 
-    return avl_join(union_left, right->value, union_right);
+    //k estava nas duas arvores, entao sai do resultado
+    if (split.present) {
+        (*common)++;
+        return avl_join_no_key(pool, sym_left, sym_right);
+    }
+
+    return avl_join(pool, sym_left, k, sym_right);
 }
 
 /*
 Operação de encontrar a interseção de duas arvores AVL
-descarta os valores que não estão presentees em ambas as árvores
+descarta os valores que não estão presentees em ambas as árvores.
+Soma em common quantos valores ficaram
 */
-static AVL_NODE *avl_intersection(AVL_NODE *left, AVL_NODE *right)
+static AVL_NODE *avl_intersection(POOL *pool, AVL_NODE *left, AVL_NODE *right, size_t *common)
 {
     if (!left) {
-        avl_free_impl(right);
+        avl_unref(pool, right);
         return NULL;
     }
 
     if (!right) {
-        avl_free_impl(left);
+        avl_unref(pool, left);
         return NULL;
     }
 
-    AVL_SPLIT split = avl_split(left, right->value);
+    AVL_NODE *right_left, *right_right;
+    int k = avl_take(pool, right, &right_left, &right_right);
 
-    AVL_NODE *intersect_left = avl_intersection(split.left, right->left);
-    AVL_NODE *intersect_right = avl_intersection(split.right, right->right);
-
-    if (split.present) {
-        AVL_NODE *joined = avl_join(intersect_left, right->value, intersect_right);
+    AVL_SPLIT split = avl_split(pool, left, k);
 
-        free(right);
+    AVL_NODE *intersect_left = avl_intersection(pool, split.left, right_left, common);
+    AVL_NODE *intersect_right = avl_intersection(pool, split.right, right_right, common);
 
-        return joined;
+    if (split.present) {
+        (*common)++;
+        return avl_join(pool, intersect_left, k, intersect_right);
     } else {
-        free(right);
-        return avl_join_no_key(intersect_left, intersect_right);
+        return avl_join_no_key(pool, intersect_left, intersect_right);
     }
 }
 
 
-static AVL_NODE *avl_insert_impl(AVL_NODE *root, int value, bool *inserted)
+AVL_NODE *avl_search_impl(AVL_NODE *root, int value);
+
+static AVL_NODE *avl_insert_impl(POOL *pool, AVL_NODE *root, int value, bool *inserted)
 {
     //caso a arvore esteja, vazia ele cria e coloca o novo node
     if (!root) {
-        root = avl_node_new(value);
+        root = avl_node_new(pool, value);
         *inserted = true;
     }
 
+    if (value == root->value)
+        return root;
+
+    root = avl_own(pool, root);
+
     //Localiza a posição do novo valor
     if (value < root->value) {
-        root->left = avl_insert_impl(root->left, value, inserted);
+        root->left = avl_insert_impl(pool, root->left, value, inserted);
     } else if (value > root->value) {
-        root->right = avl_insert_impl(root->right, value, inserted);
+        root->right = avl_insert_impl(pool, root->right, value, inserted);
     }
 
     //atualiza a altura da arvore
@@ -419,18 +596,18 @@ static AVL_NODE *avl_insert_impl(AVL_NODE *root, int value, bool *inserted)
         int bf_right = avl_height(root->right->left) - avl_height(root->right->right);
 
         if (bf_right <= 0)
-            root = avl_rotate_left(root);
+            root = avl_rotate_left(pool, root);
         else
-            root = avl_rotate_right_left(root);
+            root = avl_rotate_right_left(pool, root);
     }
 
     if (bf == 2) {
         int bf_left = avl_height(root->left->left) - avl_height(root->left->right);
 
         if (bf_left >= 0)
-            root = avl_rotate_right(root);
+            root = avl_rotate_right(pool, root);
         else
-            root = avl_rotate_left_right(root);
+            root = avl_rotate_left_right(pool, root);
     }
 
     return root;
@@ -448,9 +625,14 @@ bool avl_tree_insert(AVL_TREE *tree, int value)
     if (!tree)
         return false;
 
+    //com nodes divididos entre versões, o caminho so e copiado se o valor for
+    //mesmo entrar, o que e conferido uma vez aqui em vez de a cada nivel
+    if (!pool_exclusive(tree->pool) && avl_search_impl(tree->root, value))
+        return false;
+
     bool inserted = false;
 
-    tree->root = avl_insert_impl(tree->root, value, &inserted);
+    tree->root = avl_insert_impl(tree->pool, tree->root, value, &inserted);
 
     if (inserted)
         tree->len++;
@@ -491,6 +673,16 @@ size_t avl_tree_len(AVL_TREE *tree)
 }
 
 
+//bytes reservados pelo pool, contando os nodes livres e os das copias
+size_t avl_tree_memory(AVL_TREE *tree)
+{
+    if (!tree)
+        return 0;
+
+    return sizeof *tree + pool_size(tree->pool);
+}
+
+
 /*
 Realiza um percurso em ordem na AVL realizando a operação (cb)
 para cada valor encontrado
@@ -515,67 +707,260 @@ void avl_tree_traverse(AVL_TREE *tree, void (*cb)(int value, void *ctx), void *c
     avl_traverse_impl(tree->root, cb, ctx);
 }
 
+//Prepara um percurso em ordem da arvore, sem alocar memoria
+void avl_iter_init(AVL_ITER *it, AVL_TREE *tree)
+{
+    it->top = 0;
+    avl_iter_descend(it, tree ? tree->root : NULL);
+}
+
+/////VERSÕES PARALELAS (FORK-JOIN)/////
+
+//operação executada por uma tarefa paralela
+enum avl_task_op {
+    AVL_TASK_UNION,
+    AVL_TASK_INTERSECTION
+};
 
 /*
-função para clonar uma arvore AVL, sendo avl_clone_impl()
-utilizando para clonar de forma recursiva os nodes
+Um dos dois ramos de uma recursão, executado numa outra thread.
+O pool nao e compartilhado entre threads: cada tarefa tem um pool de ramo
+(pool_branch), que pega objetos livres do pool de quem a criou e e
+absorvido por ele depois do pthread_join(). Os dois
+ramos cobrem intervalos de valores disjuntos, entao nunca tocam o mesmo
+node, nem mesmo os compartilhados entre versões
 */
-AVL_NODE *avl_clone_impl(AVL_NODE *original)
+typedef struct avl_task {
+    enum avl_task_op op;
+
+    POOL *pool;
+    AVL_NODE *left;
+    AVL_NODE *right;
+
+    //niveis de recursão em que ainda se pode criar threads
+    int depth;
+
+    //valores em comum contados pela tarefa
+    size_t common;
+
+    AVL_NODE *result;
+} AVL_TASK;
+
+static void avl_task_run(AVL_TASK *task);
+
+static void *avl_task_thread(void *arg)
 {
-    if (!original)
-        return NULL;
+    avl_task_run(arg);
+    return NULL;
+}
 
-    AVL_NODE *clone = avl_node_new(original->value);
+/*
+Executa as duas tarefas, a primeira numa thread nova e a segunda na thread
+atual, cada uma com um pool de ramo. Se a thread nao puder ser criada, as
+duas rodam aqui mesmo, com o pool de quem chamou
+*/
+static void avl_fork_join(POOL *pool, AVL_TASK *forked, AVL_TASK *here)
+{
+    pthread_t thread;
 
-    clone->left = avl_clone_impl(original->left);
-    clone->right = avl_clone_impl(original->right);
+    forked->pool = pool_branch(pool);
+    here->pool = pool_branch(pool);
 
-    return clone;
+    bool spawned = forked->pool && here->pool && pthread_create(&thread, NULL, avl_task_thread, forked) == 0;
+
+    if (!spawned) {
+        pool_free(&forked->pool);
+        pool_free(&here->pool);
+
+        forked->pool = here->pool = pool;
+        avl_task_run(forked);
+        avl_task_run(here);
+
+        return;
+    }
+
+    avl_task_run(here);
+    pthread_join(thread, NULL);
+
+    pool_merge(pool, &forked->pool);
+    pool_merge(pool, &here->pool);
+}
+
+//se o problema e grande o bastante (e ainda ha threads) para dividir
+static bool avl_should_fork(int depth, AVL_NODE *left, AVL_NODE *right)
+{
+    return depth > 0 && MAX(avl_height(left), avl_height(right)) >= AVL_PARALLEL_HEIGHT;
 }
 
 /*
-Usado para atualizar o comprimento (len) da árvore durante um percurso
-incrementando o contador de tamanho durante o percurso
+União paralela: igual a avl_union(), mas as duas uniões recursivas
+dos lados da divisão rodam em threads diferentes
 */
-static void avl_update_len_cb(int value, void *ctx)
+static AVL_NODE *avl_union_parallel(POOL *pool, AVL_NODE *left, AVL_NODE *right, size_t *common, int depth)
+{
+    if (!left || !right || !avl_should_fork(depth, left, right))
+        return avl_union(pool, left, right, common);
+
+    AVL_NODE *right_left, *right_right;
+    int k = avl_take(pool, right, &right_left, &right_right);
+
+    AVL_SPLIT split = avl_split(pool, left, k);
+
+    AVL_TASK lower = { AVL_TASK_UNION, NULL, split.left, right_left, depth - 1, 0, NULL };
+    AVL_TASK upper = { AVL_TASK_UNION, NULL, split.right, right_right, depth - 1, 0, NULL };
+
+    avl_fork_join(pool, &lower, &upper);
+
+    *common += lower.common + upper.common + split.present;
+
+    return avl_join(pool, lower.result, k, upper.result);
+}
+
+//Interseção paralela, nos moldes da avl_union_parallel()
+static AVL_NODE *avl_intersection_parallel(POOL *pool, AVL_NODE *left, AVL_NODE *right, size_t *common, int depth)
+{
+    if (!left || !right || !avl_should_fork(depth, left, right))
+        return avl_intersection(pool, left, right, common);
+
+    AVL_NODE *right_left, *right_right;
+    int k = avl_take(pool, right, &right_left, &right_right);
+
+    AVL_SPLIT split = avl_split(pool, left, k);
+
+    AVL_TASK lower = { AVL_TASK_INTERSECTION, NULL, split.left, right_left, depth - 1, 0, NULL };
+    AVL_TASK upper = { AVL_TASK_INTERSECTION, NULL, split.right, right_right, depth - 1, 0, NULL };
+
+    avl_fork_join(pool, &lower, &upper);
+
+    *common += lower.common + upper.common;
+
+    if (split.present) {
+        (*common)++;
+        return avl_join(pool, lower.result, k, upper.result);
+    }
+
+    return avl_join_no_key(pool, lower.result, upper.result);
+}
+
+static void avl_task_run(AVL_TASK *task)
 {
-    (void)value;
-    
-    size_t *new_len = ctx;
-    *new_len = *new_len + 1;
+    switch (task->op) {
+        case AVL_TASK_UNION:
+            task->result = avl_union_parallel(task->pool, task->left, task->right, &task->common, task->depth);
+            break;
+        case AVL_TASK_INTERSECTION:
+            task->result = avl_intersection_parallel(task->pool, task->left, task->right, &task->common, task->depth);
+            break;
+    }
 }
 
-//cria a copia da AVL e instancia a avl_clone_impl()
+//quantos niveis de fork sao necessarios para ocupar `threads` threads
+static int avl_fork_depth(int threads)
+{
+    int depth = 0;
+
+    while (depth < 16 && (1 << depth) < threads)
+        depth++;
+
+    return depth;
+}
+
+/*
+cria uma copia da AVL em O(1): a copia e uma nova versão que divide
+todos os nodes (e o pool) com a original. Depois, cada uma copia so os
+nodes que modificar
+*/
 AVL_TREE *avl_tree_clone(AVL_TREE *tree)
 {
-    AVL_TREE *clone = avl_tree_new();
+    AVL_TREE *clone = malloc(sizeof *clone);
 
+    clone->root = avl_ref(tree->root);
     clone->len = tree->len;
-    clone->root = avl_clone_impl(tree->root);
+    clone->pool = pool_ref(tree->pool);
 
     return clone;
 }
 
 
+//copia a subarvore, com a mesma forma, em nodes do pool
+static AVL_NODE *avl_copy(POOL *pool, AVL_NODE *root)
+{
+    if (!root)
+        return NULL;
+
+    AVL_NODE *node = avl_node_new(pool, root->value);
+
+    node->height = root->height;
+    node->left = avl_copy(pool, root->left);
+    node->right = avl_copy(pool, root->right);
+
+    return node;
+}
+
+/*
+As operações abaixo consomem (b), mas o pool de (b) nunca e juntado ao de
+(a): como (a) pode ser uma copia de uma arvore antiga, esse pool passaria a
+guardar os slabs de todo conjunto temporario com que ela fosse combinada.
+
+Na união e na diferença simetrica os nodes de (b) ficam no resultado, entao
+a menor das duas e copiada para o pool da maior, em O(m), o que a operação
+ja custa. Na interseção e na diferença nenhum node de (b) fica: com uma
+referencia a mais na raiz, todo node de (b) alcançado e compartilhado, e
+so e lido. Depois, (b) e liberada com o seu proprio pool
+*/
+
+//fixa (a) como a maior, para que a menor seja a copiada
+static void avl_larger_first(AVL_TREE ***a, AVL_TREE ***b)
+{
+    if ((**b)->len > (**a)->len) {
+        AVL_TREE **tmp = *a;
+        *a = *b;
+        *b = tmp;
+    }
+}
+
+//consome a arvore b, retornando uma copia dos seus nodes feita no pool
+static AVL_NODE *avl_adopt(POOL *pool, AVL_TREE **b)
+{
+    AVL_NODE *root = avl_copy(pool, (*b)->root);
+
+    avl_tree_free(b);
+
+    return root;
+}
+
 /*
 Calcula a UNIAO de duas Arvores AVL, utilizando a avl_union()
 modificando o ponteiro (a), depois de colocar a resposta em 
-result, libera a memoria de ambas as arvores, depois percorre 
-a arvore para calcular len
+result, libera a memoria de ambas as arvores. O len sai da contagem
+de valores em comum feita pela avl_union(). O resultado fica no pool da
+maior das duas, para onde a menor e copiada antes (avl_adopt())
 */
 AVL_TREE *avl_tree_union(AVL_TREE **a, AVL_TREE **b)
 {
-    (*a)->root = avl_union((*a)->root, (*b)->root);
+    return avl_tree_union_parallel(a, b, 1);
+}
 
-    AVL_TREE *result = *a;
+/*
+União usando ate `threads` threads: os ramos da recursão da avl_union()
+sao divididos entre elas enquanto as subarvores forem grandes
+*/
+AVL_TREE *avl_tree_union_parallel(AVL_TREE **a, AVL_TREE **b, int threads)
+{
+    size_t common = 0;
 
-    *a = NULL;
+    avl_larger_first(&a, &b);
+
+    size_t len_b = (*b)->len;
+    AVL_NODE *right = avl_adopt((*a)->pool, b);
 
-    free(*b);
-    *b = NULL;
+    (*a)->root = avl_union_parallel((*a)->pool, (*a)->root, right, &common, avl_fork_depth(threads));
 
-    result->len = 0;
-    avl_tree_traverse(result, avl_update_len_cb, &result->len);
+    AVL_TREE *result = *a;
+
+    result->len += len_b - common;
+
+    *a = NULL;
 
     return result;
 }
@@ -587,85 +972,129 @@ librera a memoria da segunda arvore (b)
 */
 AVL_TREE *avl_tree_intersection(AVL_TREE **a, AVL_TREE **b)
 {
-    (*a)->root = avl_intersection((*a)->root, (*b)->root);
+    return avl_tree_intersection_parallel(a, b, 1);
+}
+
+//Interseção usando ate `threads` threads
+AVL_TREE *avl_tree_intersection_parallel(AVL_TREE **a, AVL_TREE **b, int threads)
+{
+    size_t common = 0;
+
+    (*a)->root = avl_intersection_parallel((*a)->pool, (*a)->root, avl_ref((*b)->root), &common, avl_fork_depth(threads));
+    avl_tree_free(b);
     //calcula a interseção das duas arvores, atulizando (a)
 
     AVL_TREE *result = *a;
 
+    //o tamanho da interseção foi contado durante a avl_intersection()
+    result->len = common;
+
     *a = NULL;
 
-    free(*b);
-    *b = NULL;
+    //retorna a arvore resultante da interseção
+    return result;
+}
+
+/*
+Modifica a primeira arvore (a) para conter os valores que nao estao na
+segunda (b), liberada no final
+*/
+AVL_TREE *avl_tree_difference(AVL_TREE **a, AVL_TREE **b)
+{
+    size_t removed = 0;
 
-    result->len = 0;
-    //percorre a arvore resultante para calcular o valor de len
-    avl_tree_traverse(result, avl_update_len_cb, &result->len);
+    (*a)->root = avl_difference((*a)->pool, (*a)->root, avl_ref((*b)->root), &removed);
+    avl_tree_free(b);
+
+    AVL_TREE *result = *a;
+
+    result->len -= removed;
+
+    *a = NULL;
 
-    //retorna a arvore resultante da interseção
     return result;
 }
 
-//operação recursiva para apagar a arvore
-void avl_free_impl(AVL_NODE *root)
+/*
+Modifica a primeira arvore (a) para conter os valores que estao em apenas
+uma das duas arvores, consumindo a segunda (b)
+*/
+AVL_TREE *avl_tree_symmetric_difference(AVL_TREE **a, AVL_TREE **b)
 {
-    if (!root)
-        return;
+    size_t common = 0;
+
+    avl_larger_first(&a, &b);
+
+    size_t len_b = (*b)->len;
+    AVL_NODE *right = avl_adopt((*a)->pool, b);
+
+    (*a)->root = avl_symmetric_difference((*a)->pool, (*a)->root, right, &common);
 
-    avl_free_impl(root->left);
-    avl_free_impl(root->right);
+    AVL_TREE *result = *a;
+
+    result->len += len_b - 2 * common;
 
-    free(root);
+    *a = NULL;
+
+    return result;
 }
 
-//função para apagar a arvore
-void avl_tree_free(AVL_TREE **tree)
+/*
+Aplica um lote de atualizações: ins e del estão em ordem estritamente
+crescente. Cada lote vira uma arvore balanceada no pool da propria arvore,
+que entra por união (ins) e depois por diferença (del), em
+O(m log(n/m + 1)) em vez de um rebalanceamento por valor
+*/
+void avl_tree_apply_sorted(AVL_TREE *tree, const int *ins, size_t n_ins, const int *del, size_t n_del)
 {
-    if (!tree || !*tree)
+    if (!tree)
         return;
 
-    avl_free_impl((*tree)->root);
+    if (n_ins > 0) {
+        size_t common = 0;
+        AVL_NODE *batch = avl_build_impl(tree->pool, ins, n_ins);
 
-    free(*tree);
-    *tree = NULL;
-}
+        tree->root = avl_union(tree->pool, tree->root, batch, &common);
+        tree->len += n_ins - common;
+    }
 
-void swap_max_left(AVL_NODE *swap, AVL_NODE *root, AVL_NODE *before){
+    if (n_del > 0) {
+        size_t removed = 0;
+        AVL_NODE *batch = avl_build_impl(tree->pool, del, n_del);
 
-    if(swap->right != NULL){ 
-        //se ainda não cheguei em um node que não tem filho pela direita, ou seja,
-        //ainda não cheguei no maior node que está na esquerda
-        //continuo minha recursão
-        swap_max_left(swap->right, root, swap);
-        return;
+        tree->root = avl_difference(tree->pool, tree->root, batch, &removed);
+        tree->len -= removed;
     }
+}
 
-    if(root == before){ 
-        //se minha raiz é igual o meu anterior
-        //logo, eu já chamei a função e cheguei no caso em que meu filho esquerdo
-        //já é o meu maior filho da esquerda
+/*
+função para apagar a arvore: se ela e a unica a usar o pool, os slabs saem
+de uma vez, sem percorrer os nodes. Senao, solta so os nodes que nenhuma
+outra versão enxerga
+*/
+void avl_tree_free(AVL_TREE **tree)
+{
+    if (!tree || !*tree)
+        return;
 
-        before->left = swap->left;
-        //troco a ligação da minha raiz com o filho esquerdo de quem quero trocar
-    }else{
-        //caso não caia no caso especificado anteriormente
+    if (!pool_exclusive((*tree)->pool))
+        avl_unref((*tree)->pool, (*tree)->root);
 
-        before->right = swap->left;
-        //troco o filho do meu node anterior de quem eu vou trocar
-        //com o filho esquerdo de quem quero trocar
+    pool_free(&(*tree)->pool);
 
-    }
-    //mudo os valores 
-    root->value = swap->value;
-    //dou free no node que quero tirar
-    free(swap);
-    swap = NULL;
+    free(*tree);
+    *tree = NULL;
 }
 
-AVL_NODE *avl_tree_remove_aux(AVL_NODE **root, int value, bool *remove){
+static AVL_NODE *avl_tree_remove_aux(POOL *pool, AVL_NODE **root, int value, bool *remove){
     if(*root == NULL){ 
         return NULL; //se cheguei em um cara NULL, logo, retorno NULL
+    }
 
-    }else if(value == (*root)->value){ //encontrei o valor desejado!
+    //a partir daqui o node vai ser modificado, entao tem que ser so meu
+    *root = avl_own(pool, *root);
+
+    if(value == (*root)->value){ //encontrei o valor desejado!
 
         *remove = true; //coloco minha FLAG para true
 
@@ -683,29 +1112,42 @@ AVL_NODE *avl_tree_remove_aux(AVL_NODE **root, int value, bool *remove){
                 *root = (*root)->left;
             }
             //dou free nessa raiz, pelo aux
-            free(aux);
+            pool_release(pool, aux);
             aux = NULL;
 
         }else{ 
             //caso 3, o no que preciso retirar tem ambos os filhos
-            //vou trocar ele pelo o maior da esquerda e depois retirar ele
-            swap_max_left((*root)->left, (*root), (*root));
+            //copio para ele o maior da esquerda e depois retiro esse maior
+            //da subarvore esquerda, rebalanceando o caminho ate ele
+            AVL_NODE *max = (*root)->left;
+
+            while(max->right != NULL){
+                max = max->right;
+            }
+
+            (*root)->value = max->value;
+
+            bool removed_max = false;
+            (*root)->left = avl_tree_remove_aux(pool, &(*root)->left, (*root)->value, &removed_max);
         }
         
     }else if(value < (*root)->value){ 
 
         //se minha chave procurada é menor que meu node atual
         //logo, vou para a esquerda
-        (*root)->left = avl_tree_remove_aux(&(*root)->left, value, remove);
+        (*root)->left = avl_tree_remove_aux(pool, &(*root)->left, value, remove);
 
     }else if(value > (*root)->value){
 
         //se minha chave procurada é maior que meu node atual
         //logo, vou para a direita
-        (*root)->right = avl_tree_remove_aux(&(*root)->right, value, remove);
+        (*root)->right = avl_tree_remove_aux(pool, &(*root)->right, value, remove);
     }
 
     if(*root != NULL){
+        //atualizo a altura, que pode ter mudado com a remoção
+        UPDATE_HEIGHT(*root);
+
         //calculo do fator de balanceamento do nó
         int FB = avl_height((*root)->left) - avl_height((*root)->right);
 
@@ -714,12 +1156,12 @@ AVL_NODE *avl_tree_remove_aux(AVL_NODE **root, int value, bool *remove){
             if((avl_height(((*root)->left)->left) -  avl_height(((*root)->left)->right)) >= 0)
                 //se o fator de balancemanto do meu filho esquero, tiver o mesmo sinal que eu
                 //logo, preciso fazer uma rotação simples para direita
-                *root = avl_rotate_right(*root);
+                *root = avl_rotate_right(pool, *root);
 
             else
                 //caso tenha sinal oposto, então eu preciso fazer uma rotação dupla
                 //uma rotação esquerda direita
-                *root = avl_rotate_left_right(*root);
+                *root = avl_rotate_left_right(pool, *root);
         }
 
         if(FB == -2){
@@ -730,12 +1172,12 @@ AVL_NODE *avl_tree_remove_aux(AVL_NODE **root, int value, bool *remove){
             if((avl_height(((*root)->right)->left) -  avl_height(((*root)->right)->right)) <= 0)
                 //se o fator de balancemanto do meu filho direito, tiver o mesmo sinal que eu
                 //logo, preciso fazer uma rotação simples para esquerda
-                *root = avl_rotate_left(*root);
+                *root = avl_rotate_left(pool, *root);
 
             else
                 //caso tenha sinal oposto, então eu preciso fazer uma rotação dupla
                 //uma rotação direita esquerda
-                *root = avl_rotate_right_left(*root);
+                *root = avl_rotate_right_left(pool, *root);
         }
             
     }
@@ -744,8 +1186,12 @@ AVL_NODE *avl_tree_remove_aux(AVL_NODE **root, int value, bool *remove){
 
 bool avl_tree_remove(AVL_TREE *T, int value){
     if(T == NULL) return false; //árvore inexistente
+
+    //com nodes divididos entre versões, so copio o caminho se o valor existir
+    if(!pool_exclusive(T->pool) && !avl_search_impl(T->root, value)) return false;
+
     bool remove = false; //minha flag, inicializo minha flag como false no começo
-    T->root = avl_tree_remove_aux(&T->root, value, &remove);
+    T->root = avl_tree_remove_aux(T->pool, &T->root, value, &remove);
 
     if (remove) T->len--;
     return remove; //minha resposta é minha flag
@@ -6,7 +6,35 @@
 
 typedef struct avl_tree AVL_TREE;
 
+//a altura de uma AVL com n nodes e menor que 1.44 log2(n + 2), entao 96
+//posicoes bastam para qualquer arvore que caiba na memoria
+#define AVL_ITER_DEPTH 96
+
+//node da arvore; fica aqui para que o percurso abaixo seja expandido em quem chama
+typedef struct avl_node {
+    //valor armazenado no node
+    int value;
+
+    //altura no node, usado para balanceamento
+    int height;
+
+    //quantas referencias (pais ou raizes de versões) apontam para o node;
+    //com mais de uma ele e compartilhado e nao pode ser modificado
+    unsigned refs;
+
+    //ponteiros para seus filhos esq e dir
+    struct avl_node *left;
+    struct avl_node *right;
+} AVL_NODE;
+
+//percurso em ordem sem recursao: a pilha guarda os nodes ainda nao visitados
+typedef struct avl_iter {
+    const AVL_NODE *stack[AVL_ITER_DEPTH];
+    int top;
+} AVL_ITER;
+
 AVL_TREE *avl_tree_new(void);
+AVL_TREE *avl_tree_from_sorted(const int *vals, size_t n);
 
 bool avl_tree_insert(AVL_TREE *, int value);
 bool avl_tree_remove(AVL_TREE *, int value);
@@ -14,12 +42,45 @@ bool avl_tree_search(AVL_TREE *, int value);
 
 size_t avl_tree_len(AVL_TREE *);
 
+//bytes reservados pelo pool da arvore, que as copias dividem
+size_t avl_tree_memory(AVL_TREE *);
+
 void avl_tree_traverse(AVL_TREE *, void (*cb)(int value, void *ctx), void *ctx);
 
+//o iterador deixa de valer se a arvore for modificada
+void avl_iter_init(AVL_ITER *, AVL_TREE *);
+
+//empilha o node e todos os filhos a esquerda dele, o proximo a sair e o menor
+static inline void avl_iter_descend(AVL_ITER *it, const AVL_NODE *node)
+{
+    for (; node; node = node->left)
+        it->stack[it->top++] = node;
+}
+
+//Coloca em (value) o proximo valor do percurso, retornando false ao final
+static inline bool avl_iter_next(AVL_ITER *it, int *value)
+{
+    if (it->top == 0)
+        return false;
+
+    const AVL_NODE *node = it->stack[--it->top];
+    *value = node->value;
+    avl_iter_descend(it, node->right);
+
+    return true;
+}
+
 AVL_TREE *avl_tree_clone(AVL_TREE *);
 
 AVL_TREE *avl_tree_union(AVL_TREE **, AVL_TREE **);
 AVL_TREE *avl_tree_intersection(AVL_TREE **, AVL_TREE **);
+AVL_TREE *avl_tree_difference(AVL_TREE **, AVL_TREE **);
+AVL_TREE *avl_tree_symmetric_difference(AVL_TREE **, AVL_TREE **);
+
+AVL_TREE *avl_tree_union_parallel(AVL_TREE **, AVL_TREE **, int threads);
+AVL_TREE *avl_tree_intersection_parallel(AVL_TREE **, AVL_TREE **, int threads);
+
+void avl_tree_apply_sorted(AVL_TREE *, const int *ins, size_t n_ins, const int *del, size_t n_del);
 
 void avl_tree_free(AVL_TREE **);
 
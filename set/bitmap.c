@@ -0,0 +1,876 @@
+#include <string.h>
+
+#include "bitmap.h"
+
+/* Um bloco com até BITMAP_ARRAY_MAX valores cabe num vetor de uint16_t sem
+ * ocupar mais que o mapa de bits, que tem sempre BITMAP_WORDS palavras
+ */
+#define BITMAP_ARRAY_MAX 4096
+#define BITMAP_WORDS 1024
+
+enum bitmap_kind {
+    BITMAP_ARRAY,   /* 16 bits baixos em ordem crescente */
+    BITMAP_BITS,    /* um bit para cada um dos 2^16 valores do bloco */
+    BITMAP_RUNS     /* intervalos disjuntos, em ordem */
+};
+
+/* Intervalo com os valores de `start` a `start + length` */
+typedef struct bitmap_run {
+    uint16_t start;
+    uint16_t length;
+} BITMAP_RUN;
+
+typedef struct bitmap_chunk {
+    /* 16 bits altos de todos os valores do bloco */
+    uint16_t key;
+    uint8_t kind;
+
+    /* Valores no bloco, de 1 a 2^16 */
+    uint32_t card;
+
+    /* Itens usados e alocados em `data` (valores no vetor, ou intervalos) */
+    uint32_t size;
+    uint32_t cap;
+
+    void *data;
+} BITMAP_CHUNK;
+
+/* Operação entre dois blocos com a mesma chave */
+enum bitmap_op {
+    BITMAP_OR,
+    BITMAP_AND,
+    BITMAP_ANDNOT,
+    BITMAP_XOR
+};
+
+struct bitmap {
+    /* Blocos não vazios, em ordem de chave */
+    BITMAP_CHUNK *chunks;
+    size_t count;
+    size_t cap;
+
+    size_t len;
+};
+
+static inline unsigned bitmap_popcount(uint64_t word)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(word);
+#else
+    unsigned count = 0;
+
+    for (; word; word &= word - 1)
+        count++;
+
+    return count;
+#endif
+}
+
+static inline unsigned bitmap_ctz(uint64_t word)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(word);
+#else
+    unsigned count = 0;
+
+    for (; !(word & 1); word >>= 1)
+        count++;
+
+    return count;
+#endif
+}
+
+/* Com o bit de sinal invertido, a ordem dos uint32_t é a mesma dos int */
+static inline uint32_t bitmap_key(int value)
+{
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+static inline int bitmap_value(uint16_t key, uint32_t low)
+{
+    return (int)((((uint32_t)key << 16) | low) ^ 0x80000000u);
+}
+
+BITMAP *bitmap_new(void)
+{
+    BITMAP *bitmap = malloc(sizeof *bitmap);
+
+    bitmap->chunks = NULL;
+    bitmap->count = 0;
+    bitmap->cap = 0;
+    bitmap->len = 0;
+
+    return bitmap;
+}
+
+size_t bitmap_len(BITMAP *bitmap)
+{
+    if (!bitmap)
+        return 0;
+
+    return bitmap->len;
+}
+
+size_t bitmap_memory(BITMAP *bitmap)
+{
+    if (!bitmap)
+        return 0;
+
+    size_t bytes = sizeof *bitmap + bitmap->cap * sizeof *bitmap->chunks;
+
+    for (size_t i = 0; i < bitmap->count; i++) {
+        const BITMAP_CHUNK *chunk = &bitmap->chunks[i];
+
+        switch (chunk->kind) {
+            case BITMAP_ARRAY:
+                bytes += chunk->cap * sizeof(uint16_t);
+                break;
+            case BITMAP_RUNS:
+                bytes += chunk->cap * sizeof(BITMAP_RUN);
+                break;
+            default:
+                bytes += BITMAP_WORDS * sizeof(uint64_t);
+                break;
+        }
+    }
+
+    return bytes;
+}
+
+/* Procura o bloco com a chave `key`. Retorna se ele existe, e em `*pos` sua
+ * posição (ou onde ele deveria entrar)
+ */
+static bool bitmap_find(const BITMAP *bitmap, uint16_t key, size_t *pos)
+{
+    size_t lo = 0, hi = bitmap->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (bitmap->chunks[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *pos = lo;
+
+    return lo < bitmap->count && bitmap->chunks[lo].key == key;
+}
+
+/* Posição do primeiro item de `vals` (com `n` itens) maior ou igual a `low` */
+static uint32_t bitmap_lower_bound(const uint16_t *vals, uint32_t n, uint16_t low)
+{
+    uint32_t lo = 0, hi = n;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (vals[mid] < low)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static bool bitmap_chunk_contains(const BITMAP_CHUNK *chunk, uint16_t low)
+{
+    switch (chunk->kind) {
+        case BITMAP_ARRAY: {
+            const uint16_t *vals = chunk->data;
+            uint32_t pos = bitmap_lower_bound(vals, chunk->size, low);
+
+            return pos < chunk->size && vals[pos] == low;
+        }
+        case BITMAP_BITS: {
+            const uint64_t *words = chunk->data;
+
+            return (words[low >> 6] >> (low & 63)) & 1;
+        }
+        case BITMAP_RUNS: {
+            const BITMAP_RUN *runs = chunk->data;
+            uint32_t lo = 0, hi = chunk->size;
+
+            /* Último intervalo que começa em `low` ou antes */
+            while (lo < hi) {
+                uint32_t mid = lo + (hi - lo) / 2;
+
+                if (runs[mid].start <= low)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            return lo > 0 && low - runs[lo - 1].start <= runs[lo - 1].length;
+        }
+    }
+
+    return false;
+}
+
+/* Escreve em `words` o mapa de bits do bloco, qualquer que seja seu formato */
+static void bitmap_chunk_expand(const BITMAP_CHUNK *chunk, uint64_t *words)
+{
+    if (chunk->kind == BITMAP_BITS) {
+        memcpy(words, chunk->data, BITMAP_WORDS * sizeof *words);
+        return;
+    }
+
+    memset(words, 0, BITMAP_WORDS * sizeof *words);
+
+    if (chunk->kind == BITMAP_ARRAY) {
+        const uint16_t *vals = chunk->data;
+
+        for (uint32_t i = 0; i < chunk->size; i++)
+            words[vals[i] >> 6] |= (uint64_t)1 << (vals[i] & 63);
+
+        return;
+    }
+
+    const BITMAP_RUN *runs = chunk->data;
+
+    for (uint32_t i = 0; i < chunk->size; i++) {
+        uint32_t end = (uint32_t)runs[i].start + runs[i].length;
+
+        for (uint32_t low = runs[i].start; low <= end; low++)
+            words[low >> 6] |= (uint64_t)1 << (low & 63);
+    }
+}
+
+/* Formato que ocupa menos espaço para `card` valores em `runs` intervalos */
+static enum bitmap_kind bitmap_best_kind(uint32_t card, uint32_t runs, bool allow_runs)
+{
+    size_t array_bytes = card <= BITMAP_ARRAY_MAX ? card * sizeof(uint16_t) : SIZE_MAX;
+    size_t bits_bytes = BITMAP_WORDS * sizeof(uint64_t);
+    size_t runs_bytes = runs * sizeof(BITMAP_RUN);
+
+    if (allow_runs && runs_bytes < array_bytes && runs_bytes < bits_bytes)
+        return BITMAP_RUNS;
+
+    return array_bytes <= bits_bytes ? BITMAP_ARRAY : BITMAP_BITS;
+}
+
+/* Preenche `chunk` com os `n` valores de `lows`, em ordem estritamente
+ * crescente, no formato que ocupar menos espaço
+ */
+static void bitmap_chunk_from_sorted(BITMAP_CHUNK *chunk, uint16_t key, const uint16_t *lows, uint32_t n)
+{
+    uint32_t runs = n > 0;
+
+    for (uint32_t i = 1; i < n; i++)
+        runs += lows[i] != lows[i - 1] + 1;
+
+    chunk->key = key;
+    chunk->card = n;
+    chunk->kind = bitmap_best_kind(n, runs, true);
+
+    switch (chunk->kind) {
+        case BITMAP_ARRAY:
+            chunk->size = chunk->cap = n;
+            chunk->data = malloc((n ? n : 1) * sizeof(uint16_t));
+            memcpy(chunk->data, lows, n * sizeof(uint16_t));
+            break;
+        case BITMAP_BITS: {
+            uint64_t *words = calloc(BITMAP_WORDS, sizeof *words);
+
+            for (uint32_t i = 0; i < n; i++)
+                words[lows[i] >> 6] |= (uint64_t)1 << (lows[i] & 63);
+
+            chunk->size = chunk->cap = 0;
+            chunk->data = words;
+            break;
+        }
+        case BITMAP_RUNS: {
+            BITMAP_RUN *run = malloc(runs * sizeof *run);
+
+            chunk->size = chunk->cap = runs;
+            chunk->data = run;
+
+            for (uint32_t i = 0; i < n; i++) {
+                if (i > 0 && lows[i] == lows[i - 1] + 1) {
+                    run[-1].length++;
+                } else {
+                    run->start = lows[i];
+                    run->length = 0;
+                    run++;
+                }
+            }
+            break;
+        }
+    }
+}
+
+/* Preenche `chunk` a partir do mapa de bits `words`, com `card` bits ligados, no
+ * formato que ocupar menos espaço (intervalos só com `allow_runs`)
+ */
+static void bitmap_chunk_from_words(BITMAP_CHUNK *chunk, uint16_t key, const uint64_t *words, uint32_t card, bool allow_runs)
+{
+    /* Um intervalo começa em cada bit ligado cujo anterior está desligado */
+    uint32_t runs = 0;
+    uint64_t carry = 0;
+
+    for (int i = 0; allow_runs && i < BITMAP_WORDS; i++) {
+        runs += bitmap_popcount(words[i] & ~(words[i] << 1 | carry));
+        carry = words[i] >> 63;
+    }
+
+    chunk->key = key;
+    chunk->card = card;
+    chunk->kind = bitmap_best_kind(card, runs, allow_runs);
+
+    if (chunk->kind == BITMAP_BITS) {
+        chunk->size = chunk->cap = 0;
+        chunk->data = malloc(BITMAP_WORDS * sizeof *words);
+        memcpy(chunk->data, words, BITMAP_WORDS * sizeof *words);
+
+        return;
+    }
+
+    if (chunk->kind == BITMAP_ARRAY) {
+        uint16_t *vals = malloc((card ? card : 1) * sizeof *vals);
+        uint32_t n = 0;
+
+        for (int i = 0; i < BITMAP_WORDS; i++) {
+            for (uint64_t word = words[i]; word; word &= word - 1)
+                vals[n++] = (uint16_t)(i * 64 + bitmap_ctz(word));
+        }
+
+        chunk->size = chunk->cap = card;
+        chunk->data = vals;
+
+        return;
+    }
+
+    BITMAP_RUN *run = malloc(runs * sizeof *run);
+    int32_t prev = -2;
+
+    chunk->size = chunk->cap = runs;
+    chunk->data = run;
+
+    for (int i = 0; i < BITMAP_WORDS; i++) {
+        for (uint64_t word = words[i]; word; word &= word - 1) {
+            int32_t low = i * 64 + bitmap_ctz(word);
+
+            if (low == prev + 1) {
+                run[-1].length++;
+            } else {
+                run->start = (uint16_t)low;
+                run->length = 0;
+                run++;
+            }
+
+            prev = low;
+        }
+    }
+}
+
+static void bitmap_chunk_clone(BITMAP_CHUNK *clone, const BITMAP_CHUNK *chunk)
+{
+    size_t bytes;
+
+    switch (chunk->kind) {
+        case BITMAP_ARRAY:
+            bytes = chunk->size * sizeof(uint16_t);
+            break;
+        case BITMAP_RUNS:
+            bytes = chunk->size * sizeof(BITMAP_RUN);
+            break;
+        default:
+            bytes = BITMAP_WORDS * sizeof(uint64_t);
+            break;
+    }
+
+    *clone = *chunk;
+    clone->cap = chunk->size;
+    clone->data = malloc(bytes ? bytes : 1);
+    memcpy(clone->data, chunk->data, bytes);
+}
+
+/* Troca o formato de um bloco de intervalos por vetor ou mapa de bits, que
+ * aceitam inserções e remoções pontuais
+ */
+static void bitmap_chunk_unrun(BITMAP_CHUNK *chunk)
+{
+    uint64_t words[BITMAP_WORDS];
+
+    bitmap_chunk_expand(chunk, words);
+    free(chunk->data);
+
+    bitmap_chunk_from_words(chunk, chunk->key, words, chunk->card, false);
+}
+
+/* Coloca um bloco vazio com a chave `key` na posição `pos` */
+static BITMAP_CHUNK *bitmap_chunk_insert(BITMAP *bitmap, size_t pos, uint16_t key)
+{
+    if (bitmap->count == bitmap->cap) {
+        bitmap->cap = bitmap->cap ? 2 * bitmap->cap : 4;
+        bitmap->chunks = realloc(bitmap->chunks, bitmap->cap * sizeof *bitmap->chunks);
+    }
+
+    memmove(&bitmap->chunks[pos + 1], &bitmap->chunks[pos], (bitmap->count - pos) * sizeof *bitmap->chunks);
+    bitmap->count++;
+
+    BITMAP_CHUNK *chunk = &bitmap->chunks[pos];
+
+    chunk->key = key;
+    chunk->kind = BITMAP_ARRAY;
+    chunk->card = 0;
+    chunk->size = 0;
+    chunk->cap = 4;
+    chunk->data = malloc(chunk->cap * sizeof(uint16_t));
+
+    return chunk;
+}
+
+bool bitmap_insert(BITMAP *bitmap, int value)
+{
+    if (!bitmap)
+        return false;
+
+    uint32_t key = bitmap_key(value);
+    uint16_t low = key & 0xFFFF;
+    size_t pos;
+
+    BITMAP_CHUNK *chunk = bitmap_find(bitmap, key >> 16, &pos)
+        ? &bitmap->chunks[pos]
+        : bitmap_chunk_insert(bitmap, pos, key >> 16);
+
+    if (chunk->kind == BITMAP_RUNS) {
+        if (bitmap_chunk_contains(chunk, low))
+            return false;
+
+        bitmap_chunk_unrun(chunk);
+    }
+
+    if (chunk->kind == BITMAP_ARRAY) {
+        uint16_t *vals = chunk->data;
+        uint32_t i = bitmap_lower_bound(vals, chunk->size, low);
+
+        if (i < chunk->size && vals[i] == low)
+            return false;
+
+        /* Vetor cheio: o bloco passa a ser um mapa de bits */
+        if (chunk->size == BITMAP_ARRAY_MAX) {
+            uint64_t *words = calloc(BITMAP_WORDS, sizeof *words);
+
+            for (uint32_t j = 0; j < chunk->size; j++)
+                words[vals[j] >> 6] |= (uint64_t)1 << (vals[j] & 63);
+
+            free(vals);
+            chunk->kind = BITMAP_BITS;
+            chunk->data = words;
+            chunk->size = chunk->cap = 0;
+        } else {
+            if (chunk->size == chunk->cap) {
+                chunk->cap = 2 * chunk->cap < BITMAP_ARRAY_MAX ? 2 * chunk->cap : BITMAP_ARRAY_MAX;
+                chunk->data = vals = realloc(vals, chunk->cap * sizeof *vals);
+            }
+
+            memmove(&vals[i + 1], &vals[i], (chunk->size - i) * sizeof *vals);
+            vals[i] = low;
+            chunk->size++;
+        }
+    }
+
+    if (chunk->kind == BITMAP_BITS) {
+        uint64_t *word = &((uint64_t *)chunk->data)[low >> 6];
+        uint64_t bit = (uint64_t)1 << (low & 63);
+
+        if (*word & bit)
+            return false;
+
+        *word |= bit;
+    }
+
+    chunk->card++;
+    bitmap->len++;
+
+    return true;
+}
+
+bool bitmap_remove(BITMAP *bitmap, int value)
+{
+    if (!bitmap)
+        return false;
+
+    uint32_t key = bitmap_key(value);
+    uint16_t low = key & 0xFFFF;
+    size_t pos;
+
+    if (!bitmap_find(bitmap, key >> 16, &pos) || !bitmap_chunk_contains(&bitmap->chunks[pos], low))
+        return false;
+
+    BITMAP_CHUNK *chunk = &bitmap->chunks[pos];
+
+    if (chunk->kind == BITMAP_RUNS)
+        bitmap_chunk_unrun(chunk);
+
+    if (chunk->kind == BITMAP_ARRAY) {
+        uint16_t *vals = chunk->data;
+        uint32_t i = bitmap_lower_bound(vals, chunk->size, low);
+
+        memmove(&vals[i], &vals[i + 1], (chunk->size - i - 1) * sizeof *vals);
+        chunk->size--;
+        chunk->card--;
+    } else {
+        uint64_t *words = chunk->data;
+
+        words[low >> 6] &= ~((uint64_t)1 << (low & 63));
+        chunk->card--;
+
+        /* Com poucos valores, o vetor volta a ocupar menos que o mapa */
+        if (chunk->card <= BITMAP_ARRAY_MAX) {
+            bitmap_chunk_from_words(chunk, chunk->key, words, chunk->card, false);
+            free(words);
+        }
+    }
+
+    bitmap->len--;
+
+    if (chunk->card == 0) {
+        free(chunk->data);
+
+        memmove(chunk, chunk + 1, (bitmap->count - pos - 1) * sizeof *chunk);
+        bitmap->count--;
+    }
+
+    return true;
+}
+
+bool bitmap_search(BITMAP *bitmap, int value)
+{
+    if (!bitmap)
+        return false;
+
+    uint32_t key = bitmap_key(value);
+    size_t pos;
+
+    return bitmap_find(bitmap, key >> 16, &pos) && bitmap_chunk_contains(&bitmap->chunks[pos], key & 0xFFFF);
+}
+
+void bitmap_apply_sorted(BITMAP *bitmap, const int *ins, size_t n_ins, const int *del, size_t n_del)
+{
+    /* Em ordem, os valores seguidos caem quase sempre no mesmo bloco */
+    for (size_t i = 0; i < n_ins; i++)
+        bitmap_insert(bitmap, ins[i]);
+
+    for (size_t i = 0; i < n_del; i++)
+        bitmap_remove(bitmap, del[i]);
+}
+
+/* Acrescenta ao fim de `bitmap` um bloco vazio, a ser preenchido */
+static BITMAP_CHUNK *bitmap_append(BITMAP *bitmap)
+{
+    if (bitmap->count == bitmap->cap) {
+        bitmap->cap = bitmap->cap ? 2 * bitmap->cap : 4;
+        bitmap->chunks = realloc(bitmap->chunks, bitmap->cap * sizeof *bitmap->chunks);
+    }
+
+    return &bitmap->chunks[bitmap->count++];
+}
+
+BITMAP *bitmap_from_sorted(const int *vals, size_t n)
+{
+    BITMAP *bitmap = bitmap_new();
+
+    /* Um bloco tem no máximo 2^16 valores, e nunca mais que a entrada toda */
+    size_t max = n < 65536 ? n : 65536;
+    uint16_t *lows = malloc((max ? max : 1) * sizeof *lows);
+
+    /* Os valores de um mesmo bloco são consecutivos na entrada */
+    for (size_t i = 0; i < n;) {
+        uint16_t key = bitmap_key(vals[i]) >> 16;
+        uint32_t count = 0;
+
+        for (; i < n && bitmap_key(vals[i]) >> 16 == key; i++)
+            lows[count++] = bitmap_key(vals[i]) & 0xFFFF;
+
+        bitmap_chunk_from_sorted(bitmap_append(bitmap), key, lows, count);
+    }
+
+    bitmap->len = n;
+    free(lows);
+
+    return bitmap;
+}
+
+void bitmap_traverse(BITMAP *bitmap, void (*cb)(int value, void *ctx), void *ctx)
+{
+    BITMAP_ITER it;
+    int value;
+
+    bitmap_iter_init(&it, bitmap);
+
+    while (bitmap_iter_next(&it, &value))
+        cb(value, ctx);
+}
+
+void bitmap_iter_init(BITMAP_ITER *it, BITMAP *bitmap)
+{
+    it->bitmap = bitmap;
+    it->chunk = 0;
+    it->index = 0;
+    it->offset = 0;
+    it->word = 0;
+}
+
+bool bitmap_iter_next(BITMAP_ITER *it, int *value)
+{
+    const BITMAP *bitmap = it->bitmap;
+
+    while (bitmap && it->chunk < bitmap->count) {
+        const BITMAP_CHUNK *chunk = &bitmap->chunks[it->chunk];
+
+        switch (chunk->kind) {
+            case BITMAP_ARRAY:
+                if (it->index < chunk->size) {
+                    *value = bitmap_value(chunk->key, ((const uint16_t *)chunk->data)[it->index++]);
+                    return true;
+                }
+                break;
+            case BITMAP_BITS: {
+                /* `word` guarda os bits ainda não visitados da palavra `index - 1` */
+                const uint64_t *words = chunk->data;
+
+                while (!it->word && it->index < BITMAP_WORDS)
+                    it->word = words[it->index++];
+
+                if (it->word) {
+                    *value = bitmap_value(chunk->key, (it->index - 1) * 64 + bitmap_ctz(it->word));
+                    it->word &= it->word - 1;
+                    return true;
+                }
+                break;
+            }
+            case BITMAP_RUNS: {
+                /* `offset` é a posição dentro do intervalo `index` */
+                const BITMAP_RUN *runs = chunk->data;
+
+                if (it->index < chunk->size) {
+                    const BITMAP_RUN *run = &runs[it->index];
+
+                    *value = bitmap_value(chunk->key, run->start + it->offset);
+
+                    if (it->offset == run->length) {
+                        it->index++;
+                        it->offset = 0;
+                    } else {
+                        it->offset++;
+                    }
+
+                    return true;
+                }
+                break;
+            }
+        }
+
+        it->chunk++;
+        it->index = 0;
+        it->offset = 0;
+        it->word = 0;
+    }
+
+    return false;
+}
+
+BITMAP *bitmap_clone(BITMAP *bitmap)
+{
+    BITMAP *clone = bitmap_new();
+
+    for (size_t i = 0; i < bitmap->count; i++)
+        bitmap_chunk_clone(bitmap_append(clone), &bitmap->chunks[i]);
+
+    clone->len = bitmap->len;
+
+    return clone;
+}
+
+/* Intercala dois blocos em vetor com a operação `op`, deixando o resultado em
+ * `out`. Retorna quantos valores ele tem.
+ */
+static uint32_t bitmap_merge_arrays(uint16_t *out, const BITMAP_CHUNK *a, const BITMAP_CHUNK *b, enum bitmap_op op)
+{
+    const uint16_t *x = a->data, *y = b->data;
+    uint32_t i = 0, j = 0, n = 0;
+
+    while (i < a->size && j < b->size) {
+        if (x[i] < y[j]) {
+            if (op != BITMAP_AND)
+                out[n++] = x[i];
+            i++;
+        } else if (y[j] < x[i]) {
+            if (op == BITMAP_OR || op == BITMAP_XOR)
+                out[n++] = y[j];
+            j++;
+        } else {
+            if (op == BITMAP_OR || op == BITMAP_AND)
+                out[n++] = x[i];
+            i++;
+            j++;
+        }
+    }
+
+    for (; op != BITMAP_AND && i < a->size; i++)
+        out[n++] = x[i];
+
+    for (; (op == BITMAP_OR || op == BITMAP_XOR) && j < b->size; j++)
+        out[n++] = y[j];
+
+    return n;
+}
+
+/* Combina dois blocos com a mesma chave. Retorna `false` (sem preencher `out`)
+ * se o resultado for vazio.
+ */
+static bool bitmap_chunk_op(BITMAP_CHUNK *out, const BITMAP_CHUNK *a, const BITMAP_CHUNK *b, enum bitmap_op op)
+{
+    /* Dois vetores são intercalados direto, sem passar pelo mapa de bits */
+    if (a->kind == BITMAP_ARRAY && b->kind == BITMAP_ARRAY) {
+        uint16_t lows[2 * BITMAP_ARRAY_MAX];
+        uint32_t n = bitmap_merge_arrays(lows, a, b, op);
+
+        if (n == 0)
+            return false;
+
+        bitmap_chunk_from_sorted(out, a->key, lows, n);
+
+        return true;
+    }
+
+    /* Interseção com um vetor, ou diferença de um vetor: como no Roaring, cada
+     * valor do vetor é buscado no outro bloco, sem expandir nenhum dos dois
+     */
+    if ((op == BITMAP_AND && (a->kind == BITMAP_ARRAY || b->kind == BITMAP_ARRAY))
+        || (op == BITMAP_ANDNOT && a->kind == BITMAP_ARRAY)) {
+        const BITMAP_CHUNK *array = a->kind == BITMAP_ARRAY ? a : b;
+        const BITMAP_CHUNK *other = array == a ? b : a;
+        const uint16_t *vals = array->data;
+        uint16_t lows[BITMAP_ARRAY_MAX];
+        uint32_t n = 0;
+
+        for (uint32_t i = 0; i < array->size; i++) {
+            if (bitmap_chunk_contains(other, vals[i]) == (op == BITMAP_AND))
+                lows[n++] = vals[i];
+        }
+
+        if (n == 0)
+            return false;
+
+        bitmap_chunk_from_sorted(out, a->key, lows, n);
+
+        return true;
+    }
+
+    uint64_t x[BITMAP_WORDS], y[BITMAP_WORDS];
+    uint32_t card = 0;
+
+    bitmap_chunk_expand(a, x);
+    bitmap_chunk_expand(b, y);
+
+    /* Laços simples sobre as palavras, que o compilador vetoriza */
+    switch (op) {
+        case BITMAP_OR:
+            for (int i = 0; i < BITMAP_WORDS; i++)
+                x[i] |= y[i];
+            break;
+        case BITMAP_AND:
+            for (int i = 0; i < BITMAP_WORDS; i++)
+                x[i] &= y[i];
+            break;
+        case BITMAP_ANDNOT:
+            for (int i = 0; i < BITMAP_WORDS; i++)
+                x[i] &= ~y[i];
+            break;
+        case BITMAP_XOR:
+            for (int i = 0; i < BITMAP_WORDS; i++)
+                x[i] ^= y[i];
+            break;
+    }
+
+    for (int i = 0; i < BITMAP_WORDS; i++)
+        card += bitmap_popcount(x[i]);
+
+    if (card == 0)
+        return false;
+
+    bitmap_chunk_from_words(out, a->key, x, card, true);
+
+    return true;
+}
+
+/* Percorre os blocos de `a` e `b` em ordem de chave, combinando os que estão nos
+ * dois com `op` e copiando os que estão só num deles quando a operação os mantém
+ */
+static BITMAP *bitmap_combine(BITMAP *a, BITMAP *b, enum bitmap_op op)
+{
+    BITMAP *c = bitmap_new();
+
+    bool keep_a = op != BITMAP_AND;
+    bool keep_b = op == BITMAP_OR || op == BITMAP_XOR;
+
+    size_t i = 0, j = 0;
+
+    while (i < a->count || j < b->count) {
+        const BITMAP_CHUNK *x = i < a->count ? &a->chunks[i] : NULL;
+        const BITMAP_CHUNK *y = j < b->count ? &b->chunks[j] : NULL;
+
+        if (x && (!y || x->key < y->key)) {
+            if (keep_a)
+                bitmap_chunk_clone(bitmap_append(c), x);
+            i++;
+        } else if (y && (!x || y->key < x->key)) {
+            if (keep_b)
+                bitmap_chunk_clone(bitmap_append(c), y);
+            j++;
+        } else {
+            BITMAP_CHUNK *out = bitmap_append(c);
+
+            if (!bitmap_chunk_op(out, x, y, op))
+                c->count--;
+
+            i++;
+            j++;
+        }
+    }
+
+    for (size_t k = 0; k < c->count; k++)
+        c->len += c->chunks[k].card;
+
+    return c;
+}
+
+BITMAP *bitmap_union(BITMAP *a, BITMAP *b)
+{
+    return bitmap_combine(a, b, BITMAP_OR);
+}
+
+BITMAP *bitmap_intersection(BITMAP *a, BITMAP *b)
+{
+    return bitmap_combine(a, b, BITMAP_AND);
+}
+
+BITMAP *bitmap_difference(BITMAP *a, BITMAP *b)
+{
+    return bitmap_combine(a, b, BITMAP_ANDNOT);
+}
+
+BITMAP *bitmap_symmetric_difference(BITMAP *a, BITMAP *b)
+{
+    return bitmap_combine(a, b, BITMAP_XOR);
+}
+
+void bitmap_free(BITMAP **bitmap)
+{
+    if (!bitmap || !*bitmap)
+        return;
+
+    for (size_t i = 0; i < (*bitmap)->count; i++)
+        free((*bitmap)->chunks[i].data);
+
+    free((*bitmap)->chunks);
+
+    free(*bitmap);
+    *bitmap = NULL;
+}
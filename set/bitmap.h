@@ -0,0 +1,75 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct bitmap BITMAP;
+
+/* Percurso em ordem crescente: o bloco atual e a posição dentro dele */
+typedef struct bitmap_iter {
+    const void *bitmap;
+    size_t chunk;
+    uint32_t index;
+    uint32_t offset;
+    uint64_t word;
+} BITMAP_ITER;
+
+/* Cria um bitmap comprimido, inicialmente vazio. Os valores são divididos em
+ * blocos de 2^16 pelos 16 bits altos, e cada bloco guarda os 16 bits baixos no
+ * formato que ocupar menos espaço: um vetor ordenado (blocos esparsos), um mapa
+ * de 2^16 bits (blocos densos) ou uma lista de intervalos (sequências longas).
+ */
+BITMAP *bitmap_new(void);
+
+/* Cria um bitmap com os `n` valores de `vals`, que devem estar em ordem
+ * estritamente crescente. Executa em O(n).
+ */
+BITMAP *bitmap_from_sorted(const int *vals, size_t n);
+
+/* Insere o valor `value`. Retorna `true` caso ele ainda não estivesse lá. */
+bool bitmap_insert(BITMAP *, int value);
+
+/* Remove o valor `value`. Retorna `true` se ele existia. */
+bool bitmap_remove(BITMAP *, int value);
+
+/* Insere os `n_ins` valores de `ins` e depois remove os `n_del` valores de
+ * `del`, ambos em ordem estritamente crescente.
+ */
+void bitmap_apply_sorted(BITMAP *, const int *ins, size_t n_ins, const int *del, size_t n_del);
+
+/* Realiza uma busca por `value`. Retorna `true` caso o valor seja encontrado. */
+bool bitmap_search(BITMAP *, int value);
+
+/* Retorna a quantidade de elementos, mantida a cada operação */
+size_t bitmap_len(BITMAP *);
+
+/* Retorna quantos bytes o bitmap ocupa, somando os blocos */
+size_t bitmap_memory(BITMAP *);
+
+/* Percorre os valores em ordem crescente, chamando `cb` para cada um com `ctx` */
+void bitmap_traverse(BITMAP *, void (*cb)(int value, void *ctx), void *ctx);
+
+/* Inicia um percurso em ordem crescente, que deixa de valer se o bitmap for modificado */
+void bitmap_iter_init(BITMAP_ITER *, BITMAP *);
+
+/* Coloca em `*value` o próximo valor do percurso. Retorna `false` ao final. */
+bool bitmap_iter_next(BITMAP_ITER *, int *value);
+
+/* Copia o bitmap, preservando o original */
+BITMAP *bitmap_clone(BITMAP *);
+
+/* Operações entre dois bitmaps, que são preservados. Os blocos presentes nos
+ * dois são combinados palavra a palavra (ou intercalados, se forem vetores), e
+ * a cardinalidade sai da contagem de bits.
+ */
+BITMAP *bitmap_union(BITMAP *, BITMAP *);
+BITMAP *bitmap_intersection(BITMAP *, BITMAP *);
+BITMAP *bitmap_difference(BITMAP *, BITMAP *);
+BITMAP *bitmap_symmetric_difference(BITMAP *, BITMAP *);
+
+/* Libera os blocos e o bitmap */
+void bitmap_free(BITMAP **);
+
+#endif
@@ -0,0 +1,603 @@
+#include <string.h>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define BTREE_SSE2
+#endif
+
+#include "pool.h"
+#include "btree.h"
+
+/* Folhas e nós internos ocupam 256 bytes cada (4 linhas de cache) e saem
+ * alinhados do pool. As chaves ficam no começo, para a busca vetorizada.
+ * As folhas estão em btree.h.
+ */
+#define BTREE_INNER_KEYS 20
+
+/* Ocupação mínima de todo nó, exceto a raiz */
+#define BTREE_LEAF_MIN (BTREE_LEAF_KEYS / 2)
+#define BTREE_INNER_MIN (BTREE_INNER_KEYS / 2)
+
+/* O filho `children[i]` guarda os valores `v` com `keys[i - 1] <= v < keys[i]` */
+typedef struct btree_inner {
+    int keys[BTREE_INNER_KEYS];
+    int count;
+    void *children[BTREE_INNER_KEYS + 1];
+} BTREE_INNER;
+
+typedef union btree_node {
+    BTREE_LEAF leaf;
+    BTREE_INNER inner;
+} BTREE_NODE;
+
+struct btree {
+    void *root;
+
+    /* Níveis de nós internos acima das folhas (0 se a raiz é uma folha) */
+    int height;
+
+    size_t len;
+
+    /* Slabs de onde saem folhas e nós internos */
+    POOL *pool;
+};
+
+BTREE *btree_new(void)
+{
+    BTREE *tree = malloc(sizeof *tree);
+
+    tree->root = NULL;
+    tree->height = 0;
+    tree->len = 0;
+    tree->pool = pool_new(sizeof(BTREE_NODE));
+
+    return tree;
+}
+
+size_t btree_len(BTREE *tree)
+{
+    if (!tree)
+        return 0;
+
+    return tree->len;
+}
+
+size_t btree_memory(BTREE *tree)
+{
+    if (!tree)
+        return 0;
+
+    return sizeof *tree + pool_size(tree->pool);
+}
+
+static BTREE_LEAF *btree_leaf_new(POOL *pool)
+{
+    BTREE_LEAF *leaf = pool_alloc(pool);
+
+    leaf->count = 0;
+    leaf->next = NULL;
+
+    return leaf;
+}
+
+static BTREE_INNER *btree_inner_new(POOL *pool)
+{
+    BTREE_INNER *inner = pool_alloc(pool);
+
+    inner->count = 0;
+
+    return inner;
+}
+
+/* Quantas das `n` chaves ordenadas de `keys` são menores que `value` (ou menores
+ * ou iguais, com `inclusive`). Dentro da linha de cache certa, compara quatro chaves
+ * por vez com SSE2, parando no primeiro grupo que não é todo contado.
+ */
+static inline int btree_rank(const int *keys, int n, int value, bool inclusive)
+{
+    int rank = 0;
+
+    /* Pula blocos de 16 chaves (uma linha de cache) inteiros pela última chave de cada */
+    while (rank + 16 < n && (keys[rank + 15] < value || (inclusive && keys[rank + 15] == value)))
+        rank += 16;
+
+#ifdef BTREE_SSE2
+    __m128i v = _mm_set1_epi32(value);
+
+    for (int i = rank; i < n; i += 4) {
+        __m128i k = _mm_loadu_si128((const __m128i *)(keys + i));
+        int mask;
+
+        /* Um bit por chave contada: k < v, ou !(k > v) com `inclusive` */
+        if (inclusive)
+            mask = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(k, v))) & 0xF;
+        else
+            mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, k)));
+
+        /* Descarta as posições depois da última chave */
+        if (n - i < 4)
+            mask &= (1 << (n - i)) - 1;
+
+        rank += __builtin_popcount(mask);
+
+        if (mask != 0xF)
+            break;
+    }
+#else
+    while (rank < n && (keys[rank] < value || (inclusive && keys[rank] == value)))
+        rank++;
+#endif
+
+    return rank;
+}
+
+static inline void btree_prefetch(const void *node)
+{
+#ifdef __GNUC__
+    for (size_t offset = 0; offset < sizeof(BTREE_NODE); offset += 64)
+        __builtin_prefetch((const char *)node + offset);
+#else
+    (void)node;
+#endif
+}
+
+bool btree_search(BTREE *tree, int value)
+{
+    if (!tree || !tree->root)
+        return false;
+
+    const void *node = tree->root;
+
+    for (int level = tree->height; level > 0; level--) {
+        const BTREE_INNER *inner = node;
+        node = inner->children[btree_rank(inner->keys, inner->count, value, true)];
+
+        /* Pede as linhas de cache do filho de uma vez, em vez de uma a uma na busca */
+        btree_prefetch(node);
+    }
+
+    const BTREE_LEAF *leaf = node;
+    int pos = btree_rank(leaf->keys, leaf->count, value, false);
+
+    return pos < leaf->count && leaf->keys[pos] == value;
+}
+
+/* Resultado de inserir numa subárvore */
+enum btree_status {
+    BTREE_PRESENT,
+    BTREE_INSERTED,
+    BTREE_SPLIT
+};
+
+/* Insere `value` na subárvore `node`, que tem `level` níveis internos. Se o nó
+ * se dividir, a metade direita vai para `*right` e sua menor chave para `*sep`.
+ */
+static enum btree_status btree_insert_impl(POOL *pool, void *node, int level, int value, int *sep, void **right)
+{
+    if (level == 0) {
+        BTREE_LEAF *leaf = node;
+        int pos = btree_rank(leaf->keys, leaf->count, value, false);
+
+        if (pos < leaf->count && leaf->keys[pos] == value)
+            return BTREE_PRESENT;
+
+        if (leaf->count < BTREE_LEAF_KEYS) {
+            memmove(&leaf->keys[pos + 1], &leaf->keys[pos], (leaf->count - pos) * sizeof(int));
+            leaf->keys[pos] = value;
+            leaf->count++;
+
+            return BTREE_INSERTED;
+        }
+
+        /* Folha cheia: as BTREE_LEAF_KEYS + 1 chaves se dividem entre ela e uma nova */
+        int keys[BTREE_LEAF_KEYS + 1];
+
+        memcpy(keys, leaf->keys, pos * sizeof(int));
+        keys[pos] = value;
+        memcpy(&keys[pos + 1], &leaf->keys[pos], (BTREE_LEAF_KEYS - pos) * sizeof(int));
+
+        BTREE_LEAF *new = btree_leaf_new(pool);
+        int left = (BTREE_LEAF_KEYS + 1) / 2;
+
+        memcpy(leaf->keys, keys, left * sizeof(int));
+        leaf->count = left;
+
+        memcpy(new->keys, &keys[left], (BTREE_LEAF_KEYS + 1 - left) * sizeof(int));
+        new->count = BTREE_LEAF_KEYS + 1 - left;
+
+        new->next = leaf->next;
+        leaf->next = new;
+
+        *sep = new->keys[0];
+        *right = new;
+
+        return BTREE_SPLIT;
+    }
+
+    BTREE_INNER *inner = node;
+    int pos = btree_rank(inner->keys, inner->count, value, true);
+
+    int child_sep;
+    void *child_right;
+    enum btree_status status = btree_insert_impl(pool, inner->children[pos], level - 1, value, &child_sep, &child_right);
+
+    if (status != BTREE_SPLIT)
+        return status;
+
+    if (inner->count < BTREE_INNER_KEYS) {
+        memmove(&inner->keys[pos + 1], &inner->keys[pos], (inner->count - pos) * sizeof(int));
+        memmove(&inner->children[pos + 2], &inner->children[pos + 1], (inner->count - pos) * sizeof(void *));
+
+        inner->keys[pos] = child_sep;
+        inner->children[pos + 1] = child_right;
+        inner->count++;
+
+        return BTREE_INSERTED;
+    }
+
+    /* Nó cheio: a chave do meio sobe e o restante se divide entre ele e um novo */
+    int keys[BTREE_INNER_KEYS + 1];
+    void *children[BTREE_INNER_KEYS + 2];
+
+    memcpy(keys, inner->keys, pos * sizeof(int));
+    keys[pos] = child_sep;
+    memcpy(&keys[pos + 1], &inner->keys[pos], (BTREE_INNER_KEYS - pos) * sizeof(int));
+
+    memcpy(children, inner->children, (pos + 1) * sizeof(void *));
+    children[pos + 1] = child_right;
+    memcpy(&children[pos + 2], &inner->children[pos + 1], (BTREE_INNER_KEYS - pos) * sizeof(void *));
+
+    BTREE_INNER *new = btree_inner_new(pool);
+    int left = BTREE_INNER_KEYS / 2;
+
+    memcpy(inner->keys, keys, left * sizeof(int));
+    memcpy(inner->children, children, (left + 1) * sizeof(void *));
+    inner->count = left;
+
+    new->count = BTREE_INNER_KEYS - left;
+    memcpy(new->keys, &keys[left + 1], new->count * sizeof(int));
+    memcpy(new->children, &children[left + 1], (new->count + 1) * sizeof(void *));
+
+    *sep = keys[left];
+    *right = new;
+
+    return BTREE_SPLIT;
+}
+
+bool btree_insert(BTREE *tree, int value)
+{
+    if (!tree)
+        return false;
+
+    if (!tree->root) {
+        BTREE_LEAF *leaf = btree_leaf_new(tree->pool);
+
+        leaf->keys[0] = value;
+        leaf->count = 1;
+
+        tree->root = leaf;
+        tree->height = 0;
+        tree->len = 1;
+
+        return true;
+    }
+
+    int sep;
+    void *right;
+    enum btree_status status = btree_insert_impl(tree->pool, tree->root, tree->height, value, &sep, &right);
+
+    if (status == BTREE_PRESENT)
+        return false;
+
+    /* A raiz se dividiu: a árvore cresce um nível */
+    if (status == BTREE_SPLIT) {
+        BTREE_INNER *root = btree_inner_new(tree->pool);
+
+        root->keys[0] = sep;
+        root->children[0] = tree->root;
+        root->children[1] = right;
+        root->count = 1;
+
+        tree->root = root;
+        tree->height++;
+    }
+
+    tree->len++;
+
+    return true;
+}
+
+/* Refaz a ocupação dos filhos `i` e `i + 1` de `parent`, que estão `level` níveis
+ * acima das folhas, depois que um deles ficou abaixo do mínimo: se cabem num nó só
+ * eles são fundidos, senão as chaves são repartidas igualmente entre os dois.
+ */
+static void btree_rebalance(POOL *pool, BTREE_INNER *parent, int i, int level)
+{
+    if (level == 0) {
+        BTREE_LEAF *left = parent->children[i];
+        BTREE_LEAF *right = parent->children[i + 1];
+        int total = left->count + right->count;
+
+        if (total <= BTREE_LEAF_KEYS) {
+            memcpy(&left->keys[left->count], right->keys, right->count * sizeof(int));
+            left->count = total;
+            left->next = right->next;
+
+            pool_release(pool, right);
+        } else {
+            int keys[2 * BTREE_LEAF_KEYS];
+
+            memcpy(keys, left->keys, left->count * sizeof(int));
+            memcpy(&keys[left->count], right->keys, right->count * sizeof(int));
+
+            left->count = total / 2;
+            right->count = total - left->count;
+
+            memcpy(left->keys, keys, left->count * sizeof(int));
+            memcpy(right->keys, &keys[left->count], right->count * sizeof(int));
+
+            parent->keys[i] = right->keys[0];
+            return;
+        }
+    } else {
+        BTREE_INNER *left = parent->children[i];
+        BTREE_INNER *right = parent->children[i + 1];
+
+        /* A chave que separa os dois desce e entra entre as deles */
+        int total = left->count + 1 + right->count;
+
+        int keys[2 * BTREE_INNER_KEYS + 1];
+        void *children[2 * BTREE_INNER_KEYS + 2];
+
+        memcpy(keys, left->keys, left->count * sizeof(int));
+        keys[left->count] = parent->keys[i];
+        memcpy(&keys[left->count + 1], right->keys, right->count * sizeof(int));
+
+        memcpy(children, left->children, (left->count + 1) * sizeof(void *));
+        memcpy(&children[left->count + 1], right->children, (right->count + 1) * sizeof(void *));
+
+        if (total <= BTREE_INNER_KEYS) {
+            memcpy(left->keys, keys, total * sizeof(int));
+            memcpy(left->children, children, (total + 1) * sizeof(void *));
+            left->count = total;
+
+            pool_release(pool, right);
+        } else {
+            left->count = total / 2;
+            right->count = total - 1 - left->count;
+
+            memcpy(left->keys, keys, left->count * sizeof(int));
+            memcpy(left->children, children, (left->count + 1) * sizeof(void *));
+
+            memcpy(right->keys, &keys[left->count + 1], right->count * sizeof(int));
+            memcpy(right->children, &children[left->count + 1], (right->count + 1) * sizeof(void *));
+
+            parent->keys[i] = keys[left->count];
+            return;
+        }
+    }
+
+    /* Houve fusão: o filho da direita e a chave que o separava saem do pai */
+    memmove(&parent->keys[i], &parent->keys[i + 1], (parent->count - i - 1) * sizeof(int));
+    memmove(&parent->children[i + 1], &parent->children[i + 2], (parent->count - i - 1) * sizeof(void *));
+    parent->count--;
+}
+
+/* Remove `value` da subárvore `node`, com `level` níveis internos */
+static bool btree_remove_impl(POOL *pool, void *node, int level, int value)
+{
+    if (level == 0) {
+        BTREE_LEAF *leaf = node;
+        int pos = btree_rank(leaf->keys, leaf->count, value, false);
+
+        if (pos == leaf->count || leaf->keys[pos] != value)
+            return false;
+
+        memmove(&leaf->keys[pos], &leaf->keys[pos + 1], (leaf->count - pos - 1) * sizeof(int));
+        leaf->count--;
+
+        return true;
+    }
+
+    BTREE_INNER *inner = node;
+    int pos = btree_rank(inner->keys, inner->count, value, true);
+
+    if (!btree_remove_impl(pool, inner->children[pos], level - 1, value))
+        return false;
+
+    /* As chaves separadoras podem ficar com valores já removidos, sem problema:
+     * elas só precisam continuar separando os filhos
+     */
+    bool underflow = level == 1
+        ? ((BTREE_LEAF *)inner->children[pos])->count < BTREE_LEAF_MIN
+        : ((BTREE_INNER *)inner->children[pos])->count < BTREE_INNER_MIN;
+
+    if (underflow)
+        btree_rebalance(pool, inner, pos > 0 ? pos - 1 : pos, level - 1);
+
+    return true;
+}
+
+bool btree_remove(BTREE *tree, int value)
+{
+    if (!tree || !tree->root)
+        return false;
+
+    if (!btree_remove_impl(tree->pool, tree->root, tree->height, value))
+        return false;
+
+    tree->len--;
+
+    /* A raiz pode ficar com um filho só (e a árvore diminui um nível) ou vazia */
+    if (tree->height > 0 && ((BTREE_INNER *)tree->root)->count == 0) {
+        void *root = ((BTREE_INNER *)tree->root)->children[0];
+
+        pool_release(tree->pool, tree->root);
+        tree->root = root;
+        tree->height--;
+    } else if (tree->height == 0 && tree->len == 0) {
+        pool_release(tree->pool, tree->root);
+        tree->root = NULL;
+    }
+
+    return true;
+}
+
+void btree_apply_sorted(BTREE *tree, const int *ins, size_t n_ins, const int *del, size_t n_del)
+{
+    /* Em ordem, as descidas seguidas passam pelos mesmos nós, que continuam no cache */
+    for (size_t i = 0; i < n_ins; i++)
+        btree_insert(tree, ins[i]);
+
+    for (size_t i = 0; i < n_del; i++)
+        btree_remove(tree, del[i]);
+}
+
+/* Divide `n` itens em `parts` grupos de tamanhos que diferem em no máximo 1 e
+ * retorna o tamanho do grupo `i`
+ */
+static size_t btree_share(size_t n, size_t parts, size_t i)
+{
+    return n / parts + (i < n % parts);
+}
+
+BTREE *btree_from_sorted(const int *vals, size_t n)
+{
+    BTREE *tree = btree_new();
+
+    if (n == 0)
+        return tree;
+
+    /* Folhas com ocupação uniforme e, acima delas, um nível por vez; os grupos têm
+     * pelo menos metade da capacidade, então todo nó fica acima do mínimo
+     */
+    size_t count = (n + BTREE_LEAF_KEYS - 1) / BTREE_LEAF_KEYS;
+
+    void **nodes = malloc(count * sizeof *nodes);
+    int *mins = malloc(count * sizeof *mins);
+
+    BTREE_LEAF *prev = NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        BTREE_LEAF *leaf = btree_leaf_new(tree->pool);
+
+        leaf->count = btree_share(n, count, i);
+        memcpy(leaf->keys, vals, leaf->count * sizeof(int));
+        vals += leaf->count;
+
+        if (prev)
+            prev->next = leaf;
+
+        nodes[i] = prev = leaf;
+        mins[i] = leaf->keys[0];
+    }
+
+    while (count > 1) {
+        size_t parents = (count + BTREE_INNER_KEYS) / (BTREE_INNER_KEYS + 1);
+        size_t child = 0;
+
+        /* O pai `i` é gravado na posição `i`, que já foi lida */
+        for (size_t i = 0; i < parents; i++) {
+            BTREE_INNER *inner = btree_inner_new(tree->pool);
+            size_t share = btree_share(count, parents, i);
+
+            for (size_t j = 0; j < share; j++, child++) {
+                inner->children[j] = nodes[child];
+
+                if (j > 0)
+                    inner->keys[j - 1] = mins[child];
+            }
+
+            inner->count = share - 1;
+            mins[i] = mins[child - share];
+            nodes[i] = inner;
+        }
+
+        count = parents;
+        tree->height++;
+    }
+
+    tree->root = nodes[0];
+    tree->len += n;
+
+    free(nodes);
+    free(mins);
+
+    return tree;
+}
+
+/* Folha com os menores valores da árvore */
+static const BTREE_LEAF *btree_first_leaf(BTREE *tree)
+{
+    if (!tree || !tree->root)
+        return NULL;
+
+    const void *node = tree->root;
+
+    for (int level = tree->height; level > 0; level--)
+        node = ((const BTREE_INNER *)node)->children[0];
+
+    return node;
+}
+
+void btree_traverse(BTREE *tree, void (*cb)(int value, void *ctx), void *ctx)
+{
+    for (const BTREE_LEAF *leaf = btree_first_leaf(tree); leaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; i++)
+            cb(leaf->keys[i], ctx);
+    }
+}
+
+void btree_iter_init(BTREE_ITER *it, BTREE *tree)
+{
+    it->leaf = btree_first_leaf(tree);
+    it->index = 0;
+}
+
+/* Copia a subárvore `node`, encadeando as folhas copiadas depois de `*prev` */
+static void *btree_clone_impl(POOL *pool, const void *node, int level, BTREE_LEAF **prev)
+{
+    BTREE_NODE *clone = pool_alloc(pool);
+
+    memcpy(clone, node, sizeof *clone);
+
+    if (level == 0) {
+        clone->leaf.next = NULL;
+
+        if (*prev)
+            (*prev)->next = &clone->leaf;
+
+        *prev = &clone->leaf;
+    } else {
+        for (int i = 0; i <= clone->inner.count; i++)
+            clone->inner.children[i] = btree_clone_impl(pool, clone->inner.children[i], level - 1, prev);
+    }
+
+    return clone;
+}
+
+BTREE *btree_clone(BTREE *tree)
+{
+    BTREE *clone = btree_new();
+    BTREE_LEAF *prev = NULL;
+
+    clone->len = tree->len;
+    clone->height = tree->height;
+
+    if (tree->root)
+        clone->root = btree_clone_impl(clone->pool, tree->root, tree->height, &prev);
+
+    return clone;
+}
+
+/* Os nós saem junto com os slabs do pool, sem percorrer a árvore */
+void btree_free(BTREE **tree)
+{
+    if (!tree || !*tree)
+        return;
+
+    pool_free(&(*tree)->pool);
+
+    free(*tree);
+    *tree = NULL;
+}
@@ -0,0 +1,92 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct btree BTREE;
+
+#define BTREE_LEAF_KEYS 60
+
+/* Folha da árvore, com 256 bytes. Fica visível para que o percurso seja
+ * expandido em quem chama; os nós internos continuam em btree.c.
+ */
+typedef struct btree_leaf {
+    int keys[BTREE_LEAF_KEYS];
+    int count;
+
+    /* Próxima folha em ordem, para percursos sem subir na árvore */
+    struct btree_leaf *next;
+} BTREE_LEAF;
+
+/* Percurso em-ordem pelas folhas encadeadas: guarda só a folha atual e a
+ * posição dentro dela, sem pilha.
+ */
+typedef struct btree_iter {
+    const BTREE_LEAF *leaf;
+    int index;
+} BTREE_ITER;
+
+/* Cria uma árvore B+, inicialmente vazia. Cada nó ocupa algumas linhas de
+ * cache e guarda dezenas de chaves, então uma busca visita poucos nós.
+ */
+BTREE *btree_new(void);
+
+/* Cria uma árvore B+ com os `n` valores de `vals`, que devem estar em
+ * ordem estritamente crescente. Executa em O(n).
+ */
+BTREE *btree_from_sorted(const int *vals, size_t n);
+
+/* Insere o valor `value` na árvore. Retorna `true` caso a inserção
+ * tenha sido bem-sucedida.
+ */
+bool btree_insert(BTREE *, int value);
+
+/* Remove o valor `value` da árvore. Retorna `true` se ele existia. */
+bool btree_remove(BTREE *, int value);
+
+/* Insere os `n_ins` valores de `ins` e depois remove os `n_del` valores de
+ * `del`, ambos em ordem estritamente crescente.
+ */
+void btree_apply_sorted(BTREE *, const int *ins, size_t n_ins, const int *del, size_t n_del);
+
+/* Realiza uma busca por `value` na árvore. Retorna `true` caso o valor seja encontrado. */
+bool btree_search(BTREE *, int value);
+
+/* Retorna o tamanho da árvore (quantidade de elementos) */
+size_t btree_len(BTREE *);
+
+/* Retorna quantos bytes a árvore reserva (os slabs do seu pool) */
+size_t btree_memory(BTREE *);
+
+/* Percorre a árvore em-ordem, chamando `cb` para cada valor com `ctx` */
+void btree_traverse(BTREE *, void (*cb)(int value, void *ctx), void *ctx);
+
+/* Inicia um percurso em-ordem da árvore, que deixa de valer se ela for modificada */
+void btree_iter_init(BTREE_ITER *, BTREE *);
+
+/* Coloca em `*value` o próximo valor do percurso. Retorna `false` ao final. */
+static inline bool btree_iter_next(BTREE_ITER *it, int *value)
+{
+    const BTREE_LEAF *leaf = it->leaf;
+
+    if (!leaf)
+        return false;
+
+    *value = leaf->keys[it->index++];
+
+    if (it->index == leaf->count) {
+        it->leaf = leaf->next;
+        it->index = 0;
+    }
+
+    return true;
+}
+
+/* Clona a árvore, preservando a original */
+BTREE *btree_clone(BTREE *);
+
+/* Libera espaço ocupado pela árvore e nós. */
+void btree_free(BTREE **);
+
+#endif
@@ -0,0 +1,152 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "frozen.h"
+
+/* Alinhamento do vetor: com ele, os 16 descendentes de um nó quatro níveis
+ * abaixo, `keys[16k .. 16k + 15]`, ocupam exatamente uma linha de cache
+ */
+#define FROZEN_ALIGN 64
+
+struct frozen {
+    /* Valores em `keys[1 .. len]`; os filhos de `keys[k]` são `keys[2k]` e `keys[2k + 1]` */
+    int *keys;
+    size_t len;
+
+    /* Bloco devolvido pelo malloc, de onde `keys` foi alinhado */
+    void *block;
+};
+
+/* Aloca um conjunto com espaço para `n` valores, ainda não preenchidos */
+static FROZEN *frozen_alloc(size_t n)
+{
+    FROZEN *frozen = malloc(sizeof *frozen);
+
+    if (!frozen)
+        return NULL;
+
+    // FROZEN_ALIGN a mais para poder alinhar o começo do vetor
+    frozen->block = malloc((n + 1) * sizeof(int) + FROZEN_ALIGN);
+
+    if (!frozen->block) {
+        free(frozen);
+        return NULL;
+    }
+
+    uintptr_t start = (uintptr_t)frozen->block;
+    start = (start + FROZEN_ALIGN - 1) & ~(uintptr_t)(FROZEN_ALIGN - 1);
+
+    frozen->keys = (int *)start;
+    frozen->len = n;
+
+    return frozen;
+}
+
+/* Índice do menor valor da árvore implícita com `n` nós (0 se vazia) */
+static size_t frozen_first(size_t n)
+{
+    size_t k = n > 0 ? 1 : 0;
+
+    while (k > 0 && 2 * k <= n)
+        k *= 2;
+
+    return k;
+}
+
+FROZEN *frozen_from_sorted(const int *vals, size_t n)
+{
+    FROZEN *frozen = frozen_alloc(n);
+
+    if (!frozen)
+        return NULL;
+
+    /* Um percurso em-ordem da árvore implícita visita as posições na ordem dos valores */
+    size_t k = frozen_first(n);
+
+    for (size_t i = 0; i < n; i++, k = frozen_next(k, n))
+        frozen->keys[k] = vals[i];
+
+    return frozen;
+}
+
+bool frozen_search(FROZEN *frozen, int value)
+{
+    if (!frozen)
+        return false;
+
+    const int *keys = frozen->keys;
+    size_t n = frozen->len;
+    size_t k = 1;
+
+    /* Desce sempre até passar das folhas; a comparação vira o bit do próximo índice */
+    while (k <= n) {
+#ifdef __GNUC__
+        /* Os descendentes quatro níveis abaixo estão numa linha de cache só */
+        __builtin_prefetch((const char *)keys + 16 * k * sizeof(int));
+#endif
+        k = 2 * k + (keys[k] < value);
+    }
+
+    /* Os bits 1 no fim de `k` são os passos para a direita depois do último para a
+     * esquerda, que foi dado no menor valor >= `value`: descartá-los volta até ele
+     */
+    while (k & 1)
+        k >>= 1;
+
+    k >>= 1;
+
+    return k != 0 && keys[k] == value;
+}
+
+size_t frozen_len(FROZEN *frozen)
+{
+    if (!frozen)
+        return 0;
+
+    return frozen->len;
+}
+
+size_t frozen_memory(FROZEN *frozen)
+{
+    if (!frozen)
+        return 0;
+
+    return sizeof *frozen + (frozen->len + 1) * sizeof(int) + FROZEN_ALIGN;
+}
+
+void frozen_traverse(FROZEN *frozen, void (*cb)(int value, void *ctx), void *ctx)
+{
+    if (!frozen)
+        return;
+
+    for (size_t k = frozen_first(frozen->len); k != 0; k = frozen_next(k, frozen->len))
+        cb(frozen->keys[k], ctx);
+}
+
+void frozen_iter_init(FROZEN_ITER *it, FROZEN *frozen)
+{
+    it->keys = frozen ? frozen->keys : NULL;
+    it->len = frozen ? frozen->len : 0;
+    it->index = frozen_first(it->len);
+}
+
+FROZEN *frozen_clone(FROZEN *frozen)
+{
+    FROZEN *clone = frozen_alloc(frozen->len);
+
+    if (clone)
+        memcpy(clone->keys + 1, frozen->keys + 1, frozen->len * sizeof(int));
+
+    return clone;
+}
+
+void frozen_free(FROZEN **frozen)
+{
+    if (!frozen || !*frozen)
+        return;
+
+    free((*frozen)->block);
+
+    free(*frozen);
+    *frozen = NULL;
+}
@@ -0,0 +1,76 @@
+#ifndef FROZEN_H
+#define FROZEN_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct frozen FROZEN;
+
+/* Percurso em-ordem pelos índices da árvore implícita, sem pilha */
+typedef struct frozen_iter {
+    const int *keys;
+    size_t len;
+    size_t index;
+} FROZEN_ITER;
+
+/* Cria um conjunto só de leitura com os `n` valores de `vals`, que devem estar
+ * em ordem estritamente crescente. Os valores ficam num único vetor alinhado,
+ * na ordem de Eytzinger (a de uma busca em largura na árvore binária de busca
+ * completa), e a busca desce por ele sem desvios condicionais. Executa em O(n).
+ */
+FROZEN *frozen_from_sorted(const int *vals, size_t n);
+
+/* Realiza uma busca por `value`. Retorna `true` caso o valor seja encontrado. */
+bool frozen_search(FROZEN *, int value);
+
+/* Retorna a quantidade de elementos */
+size_t frozen_len(FROZEN *);
+
+/* Retorna quantos bytes o conjunto ocupa */
+size_t frozen_memory(FROZEN *);
+
+/* Percorre os valores em ordem crescente, chamando `cb` para cada um com `ctx` */
+void frozen_traverse(FROZEN *, void (*cb)(int value, void *ctx), void *ctx);
+
+/* Inicia um percurso em ordem crescente */
+void frozen_iter_init(FROZEN_ITER *, FROZEN *);
+
+/* Índice do valor seguinte ao de `k` em ordem (0 depois do maior) */
+static inline size_t frozen_next(size_t k, size_t n)
+{
+    /* Com filho direito, o sucessor é o menor valor da subárvore dele */
+    if (2 * k + 1 <= n) {
+        k = 2 * k + 1;
+
+        while (2 * k <= n)
+            k *= 2;
+
+        return k;
+    }
+
+    /* Senão, sobe enquanto vier da direita, e mais um nível */
+    while (k & 1)
+        k >>= 1;
+
+    return k >> 1;
+}
+
+/* Coloca em `*value` o próximo valor do percurso. Retorna `false` ao final. */
+static inline bool frozen_iter_next(FROZEN_ITER *it, int *value)
+{
+    if (it->index == 0)
+        return false;
+
+    *value = it->keys[it->index];
+    it->index = frozen_next(it->index, it->len);
+
+    return true;
+}
+
+/* Copia o conjunto, preservando o original */
+FROZEN *frozen_clone(FROZEN *);
+
+/* Libera o vetor e o conjunto */
+void frozen_free(FROZEN **);
+
+#endif
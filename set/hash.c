@@ -0,0 +1,472 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "hash.h"
+
+/* Bytes de controle comparados de uma vez, num uint64_t */
+#define HASH_GROUP 8
+
+#define HASH_EMPTY 0x80
+#define HASH_MIN_CAP 16
+
+/* Byte 0x01 (e 0x80) repetido em cada posição de uma palavra */
+#define HASH_LSBS 0x0101010101010101ull
+#define HASH_MSBS 0x8080808080808080ull
+
+/*
+ * Sondagem linear, procurando um grupo de HASH_GROUP posições por vez. O byte de
+ * controle de uma posição ocupada guarda 7 bits do hash do valor (sempre menor que
+ * 0x80); o de uma posição vazia vale HASH_EMPTY. Os HASH_GROUP primeiros bytes se
+ * repetem depois do último, para que um grupo perto do fim não precise dar a volta.
+ *
+ * Na sondagem linear, todas as posições entre a inicial de um valor e a que ele
+ * ocupa estão ocupadas. Por isso a remoção não precisa de marcas: ela puxa para
+ * trás os valores seguintes que podem ocupar a posição liberada.
+ */
+struct hash {
+    uint8_t *ctrl;
+    int *slots;
+
+    /* Potência de 2 */
+    size_t cap;
+    size_t len;
+
+    /* Valores em ordem, refeitos por `hash_iter_init` depois de modificações */
+    int *sorted;
+    bool sorted_valid;
+};
+
+/* Finalizador do splitmix64: espalha todos os bits do valor pelo hash */
+static inline uint64_t hash_mix(int value)
+{
+    uint64_t z = (uint32_t)value + 0x9E3779B97F4A7C15ull;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+    return z ^ (z >> 31);
+}
+
+/* Os 7 bits mais altos do hash vão para o byte de controle; os mais baixos
+ * escolhem a posição inicial
+ */
+static inline uint8_t hash_tag(uint64_t h)
+{
+    return h >> 57;
+}
+
+/* Lê os HASH_GROUP bytes de controle a partir de `pos`, o de `pos` no byte mais baixo */
+static inline uint64_t hash_group(const uint8_t *ctrl, size_t pos)
+{
+    uint64_t group;
+
+    memcpy(&group, ctrl + pos, sizeof group);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    group = __builtin_bswap64(group);
+#endif
+
+    return group;
+}
+
+/* Bit alto ligado em cada byte de `group` igual a `tag`. Pode haver falsos
+ * positivos (o valor é sempre conferido), mas nunca falsos negativos.
+ */
+static inline uint64_t hash_match(uint64_t group, uint8_t tag)
+{
+    uint64_t x = group ^ (HASH_LSBS * tag);
+
+    return (x - HASH_LSBS) & ~x & HASH_MSBS;
+}
+
+static inline uint64_t hash_match_empty(uint64_t group)
+{
+    return group & HASH_MSBS;
+}
+
+/* Posição, dentro do grupo, do primeiro byte marcado em `mask` */
+static inline size_t hash_first(uint64_t mask)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(mask) / 8;
+#else
+    size_t i = 0;
+
+    for (; !(mask & 0x80); mask >>= 8)
+        i++;
+
+    return i;
+#endif
+}
+
+static void hash_set_ctrl(HASH *hash, size_t pos, uint8_t ctrl)
+{
+    hash->ctrl[pos] = ctrl;
+
+    if (pos < HASH_GROUP)
+        hash->ctrl[hash->cap + pos] = ctrl;
+}
+
+/* Aloca uma tabela vazia com `cap` posições */
+static HASH *hash_alloc(size_t cap)
+{
+    HASH *hash = malloc(sizeof *hash);
+
+    hash->cap = cap;
+    hash->len = 0;
+    hash->ctrl = malloc(cap + HASH_GROUP);
+    hash->slots = malloc(cap * sizeof *hash->slots);
+    hash->sorted = NULL;
+    hash->sorted_valid = false;
+
+    memset(hash->ctrl, HASH_EMPTY, cap + HASH_GROUP);
+
+    return hash;
+}
+
+/* Menor capacidade que guarda `n` valores com ocupação de até 3/4 */
+static size_t hash_cap_for(size_t n)
+{
+    size_t cap = HASH_MIN_CAP;
+
+    while (cap - cap / 4 < n)
+        cap *= 2;
+
+    return cap;
+}
+
+HASH *hash_new(void)
+{
+    return hash_alloc(HASH_MIN_CAP);
+}
+
+size_t hash_len(HASH *hash)
+{
+    if (!hash)
+        return 0;
+
+    return hash->len;
+}
+
+size_t hash_memory(HASH *hash)
+{
+    if (!hash)
+        return 0;
+
+    size_t bytes = sizeof *hash + hash->cap + HASH_GROUP + hash->cap * sizeof *hash->slots;
+
+    if (hash->sorted)
+        bytes += hash->len * sizeof *hash->sorted;
+
+    return bytes;
+}
+
+/* Posição de `value` na tabela, ou `cap` se ele não estiver lá */
+static size_t hash_find(const HASH *hash, int value, uint64_t h)
+{
+    size_t mask = hash->cap - 1;
+    uint8_t tag = hash_tag(h);
+
+    for (size_t pos = h & mask;; pos = (pos + HASH_GROUP) & mask) {
+        uint64_t group = hash_group(hash->ctrl, pos);
+
+        for (uint64_t match = hash_match(group, tag); match; match &= match - 1) {
+            size_t slot = (pos + hash_first(match)) & mask;
+
+            if (hash->slots[slot] == value)
+                return slot;
+        }
+
+        /* Um valor nunca fica depois de uma posição vazia a partir da sua inicial */
+        if (hash_match_empty(group))
+            return hash->cap;
+    }
+}
+
+/* Coloca `value`, que não está na tabela, na primeira posição vazia da sua sondagem */
+static void hash_place(HASH *hash, int value, uint64_t h)
+{
+    size_t mask = hash->cap - 1;
+    size_t pos = h & mask;
+    uint64_t empty;
+
+    while (!(empty = hash_match_empty(hash_group(hash->ctrl, pos))))
+        pos = (pos + HASH_GROUP) & mask;
+
+    pos = (pos + hash_first(empty)) & mask;
+
+    hash->slots[pos] = value;
+    hash_set_ctrl(hash, pos, hash_tag(h));
+    hash->len++;
+}
+
+/* Realoca a tabela com `cap` posições, recolocando todos os valores */
+static void hash_resize(HASH *hash, size_t cap)
+{
+    uint8_t *ctrl = hash->ctrl;
+    int *slots = hash->slots;
+    size_t old_cap = hash->cap;
+
+    hash->cap = cap;
+    hash->len = 0;
+    hash->ctrl = malloc(cap + HASH_GROUP);
+    hash->slots = malloc(cap * sizeof *hash->slots);
+
+    memset(hash->ctrl, HASH_EMPTY, cap + HASH_GROUP);
+
+    for (size_t i = 0; i < old_cap; i++) {
+        if (ctrl[i] != HASH_EMPTY)
+            hash_place(hash, slots[i], hash_mix(slots[i]));
+    }
+
+    free(ctrl);
+    free(slots);
+}
+
+bool hash_search(HASH *hash, int value)
+{
+    if (!hash)
+        return false;
+
+    return hash_find(hash, value, hash_mix(value)) != hash->cap;
+}
+
+bool hash_insert(HASH *hash, int value)
+{
+    if (!hash)
+        return false;
+
+    uint64_t h = hash_mix(value);
+
+    if (hash_find(hash, value, h) != hash->cap)
+        return false;
+
+    /* Com sondagem linear, uma busca sem sucesso examina em média cerca de
+     * (1 + 1/(1 - α)²)/2 posições com ocupação α: 8,5 com 3/4, mas 32,5 com
+     * 7/8. Passando de 3/4, dobra a tabela.
+     */
+    if (hash->len + 1 > hash->cap - hash->cap / 4)
+        hash_resize(hash, 2 * hash->cap);
+
+    hash_place(hash, value, h);
+    hash->sorted_valid = false;
+
+    return true;
+}
+
+bool hash_remove(HASH *hash, int value)
+{
+    if (!hash)
+        return false;
+
+    size_t mask = hash->cap - 1;
+    size_t hole = hash_find(hash, value, hash_mix(value));
+
+    if (hole == hash->cap)
+        return false;
+
+    /* Puxa para o buraco cada valor seguinte cuja posição inicial não está entre o
+     * buraco e ele, até a próxima posição vazia
+     */
+    for (size_t pos = (hole + 1) & mask; hash->ctrl[pos] != HASH_EMPTY; pos = (pos + 1) & mask) {
+        size_t home = hash_mix(hash->slots[pos]) & mask;
+
+        if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+            hash->slots[hole] = hash->slots[pos];
+            hash_set_ctrl(hash, hole, hash->ctrl[pos]);
+            hole = pos;
+        }
+    }
+
+    hash_set_ctrl(hash, hole, HASH_EMPTY);
+    hash->len--;
+    hash->sorted_valid = false;
+
+    return true;
+}
+
+void hash_apply_sorted(HASH *hash, const int *ins, size_t n_ins, const int *del, size_t n_del)
+{
+    if (!hash)
+        return;
+
+    /* Reserva espaço para o lote inteiro de uma vez */
+    if (hash_cap_for(hash->len + n_ins) > hash->cap)
+        hash_resize(hash, hash_cap_for(hash->len + n_ins));
+
+    for (size_t i = 0; i < n_ins; i++)
+        hash_insert(hash, ins[i]);
+
+    for (size_t i = 0; i < n_del; i++)
+        hash_remove(hash, del[i]);
+}
+
+HASH *hash_from_sorted(const int *vals, size_t n)
+{
+    HASH *hash = hash_alloc(hash_cap_for(n));
+
+    for (size_t i = 0; i < n; i++)
+        hash_place(hash, vals[i], hash_mix(vals[i]));
+
+    /* A entrada já está em ordem, então serve de cache */
+    hash->sorted = malloc((n ? n : 1) * sizeof *hash->sorted);
+    memcpy(hash->sorted, vals, n * sizeof *vals);
+    hash->sorted_valid = true;
+
+    return hash;
+}
+
+static int hash_compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Deixa em `hash->sorted` os valores em ordem, se ainda não estiverem */
+static void hash_sort(HASH *hash)
+{
+    if (hash->sorted_valid)
+        return;
+
+    free(hash->sorted);
+    hash->sorted = malloc((hash->len ? hash->len : 1) * sizeof *hash->sorted);
+
+    size_t n = 0;
+
+    for (size_t i = 0; i < hash->cap; i++) {
+        if (hash->ctrl[i] != HASH_EMPTY)
+            hash->sorted[n++] = hash->slots[i];
+    }
+
+    qsort(hash->sorted, n, sizeof *hash->sorted, hash_compare_int);
+    hash->sorted_valid = true;
+}
+
+void hash_traverse(HASH *hash, void (*cb)(int value, void *ctx), void *ctx)
+{
+    if (!hash)
+        return;
+
+    hash_sort(hash);
+
+    for (size_t i = 0; i < hash->len; i++)
+        cb(hash->sorted[i], ctx);
+}
+
+void hash_iter_init(HASH_ITER *it, HASH *hash)
+{
+    if (hash)
+        hash_sort(hash);
+
+    it->vals = hash ? hash->sorted : NULL;
+    it->len = hash ? hash->len : 0;
+    it->index = 0;
+}
+
+HASH *hash_clone(HASH *hash)
+{
+    HASH *clone = hash_alloc(hash->cap);
+
+    memcpy(clone->ctrl, hash->ctrl, hash->cap + HASH_GROUP);
+    memcpy(clone->slots, hash->slots, hash->cap * sizeof *hash->slots);
+    clone->len = hash->len;
+
+    return clone;
+}
+
+HASH *hash_union(HASH *a, HASH *b)
+{
+    HASH *small = a->len < b->len ? a : b;
+    HASH *large = a->len < b->len ? b : a;
+
+    /* A cópia da maior é um memcpy; só os valores da menor são inseridos */
+    HASH *c = hash_clone(large);
+
+    for (size_t i = 0; i < small->cap; i++) {
+        if (small->ctrl[i] != HASH_EMPTY)
+            hash_insert(c, small->slots[i]);
+    }
+
+    return c;
+}
+
+HASH *hash_intersection(HASH *a, HASH *b)
+{
+    HASH *small = a->len < b->len ? a : b;
+    HASH *large = a->len < b->len ? b : a;
+
+    HASH *c = hash_alloc(hash_cap_for(small->len));
+
+    for (size_t i = 0; i < small->cap; i++) {
+        if (small->ctrl[i] != HASH_EMPTY && hash_search(large, small->slots[i]))
+            hash_place(c, small->slots[i], hash_mix(small->slots[i]));
+    }
+
+    return c;
+}
+
+HASH *hash_difference(HASH *a, HASH *b)
+{
+    /* Percorre a menor: remove os valores de `b` de uma cópia de `a`, ou copia
+     * só os valores de `a` que não estão em `b`
+     */
+    if (b->len < a->len) {
+        HASH *c = hash_clone(a);
+
+        hash_difference_inplace(c, b);
+
+        return c;
+    }
+
+    HASH *c = hash_alloc(hash_cap_for(a->len));
+
+    for (size_t i = 0; i < a->cap; i++) {
+        if (a->ctrl[i] != HASH_EMPTY && !hash_search(b, a->slots[i]))
+            hash_place(c, a->slots[i], hash_mix(a->slots[i]));
+    }
+
+    return c;
+}
+
+HASH *hash_symmetric_difference(HASH *a, HASH *b)
+{
+    HASH *small = a->len < b->len ? a : b;
+    HASH *large = a->len < b->len ? b : a;
+
+    HASH *c = hash_clone(large);
+
+    hash_symmetric_difference_inplace(c, small);
+
+    return c;
+}
+
+void hash_difference_inplace(HASH *a, HASH *b)
+{
+    for (size_t i = 0; i < b->cap; i++) {
+        if (b->ctrl[i] != HASH_EMPTY)
+            hash_remove(a, b->slots[i]);
+    }
+}
+
+void hash_symmetric_difference_inplace(HASH *a, HASH *b)
+{
+    for (size_t i = 0; i < b->cap; i++) {
+        if (b->ctrl[i] != HASH_EMPTY && !hash_remove(a, b->slots[i]))
+            hash_insert(a, b->slots[i]);
+    }
+}
+
+void hash_free(HASH **hash)
+{
+    if (!hash || !*hash)
+        return;
+
+    free((*hash)->ctrl);
+    free((*hash)->slots);
+    free((*hash)->sorted);
+
+    free(*hash);
+    *hash = NULL;
+}
@@ -0,0 +1,85 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct hash HASH;
+
+/* Percurso em ordem crescente pelo vetor ordenado que a tabela guarda */
+typedef struct hash_iter {
+    const int *vals;
+    size_t len;
+    size_t index;
+} HASH_ITER;
+
+/* Cria uma tabela hash com endereçamento aberto, inicialmente vazia. Cada
+ * posição tem um byte de controle com 7 bits do hash do valor; as buscas
+ * comparam 8 desses bytes de uma vez e só leem os valores cujo byte bate.
+ */
+HASH *hash_new(void);
+
+/* Cria uma tabela com os `n` valores de `vals`, em ordem estritamente crescente */
+HASH *hash_from_sorted(const int *vals, size_t n);
+
+/* Insere o valor `value`. Retorna `true` caso ele ainda não estivesse lá. */
+bool hash_insert(HASH *, int value);
+
+/* Remove o valor `value`, sem deixar marcas de remoção na tabela. Retorna
+ * `true` se ele existia.
+ */
+bool hash_remove(HASH *, int value);
+
+/* Insere os `n_ins` valores de `ins` e depois remove os `n_del` valores de `del` */
+void hash_apply_sorted(HASH *, const int *ins, size_t n_ins, const int *del, size_t n_del);
+
+/* Realiza uma busca por `value`. Retorna `true` caso o valor seja encontrado. */
+bool hash_search(HASH *, int value);
+
+/* Retorna a quantidade de elementos */
+size_t hash_len(HASH *);
+
+/* Retorna quantos bytes a tabela ocupa, incluindo o vetor ordenado */
+size_t hash_memory(HASH *);
+
+/* Percorre os valores em ordem crescente, chamando `cb` para cada um com `ctx`.
+ * A ordem vem de um vetor ordenado na primeira vez e guardado até a próxima
+ * modificação da tabela.
+ */
+void hash_traverse(HASH *, void (*cb)(int value, void *ctx), void *ctx);
+
+/* Inicia um percurso em ordem crescente (ordenando a tabela, se preciso), que
+ * deixa de valer se ela for modificada
+ */
+void hash_iter_init(HASH_ITER *, HASH *);
+
+/* Coloca em `*value` o próximo valor do percurso. Retorna `false` ao final. */
+static inline bool hash_iter_next(HASH_ITER *it, int *value)
+{
+    if (it->index == it->len)
+        return false;
+
+    *value = it->vals[it->index++];
+
+    return true;
+}
+
+/* Copia a tabela, preservando a original */
+HASH *hash_clone(HASH *);
+
+/* Operações entre duas tabelas, que são preservadas. União e interseção
+ * percorrem a menor e buscam cada valor na maior.
+ */
+HASH *hash_union(HASH *, HASH *);
+HASH *hash_intersection(HASH *, HASH *);
+HASH *hash_difference(HASH *, HASH *);
+HASH *hash_symmetric_difference(HASH *, HASH *);
+
+/* Versões que modificam `a`, em tempo proporcional ao tamanho de `b` */
+void hash_difference_inplace(HASH *a, HASH *b);
+void hash_symmetric_difference_inplace(HASH *a, HASH *b);
+
+/* Libera a tabela */
+void hash_free(HASH **);
+
+#endif
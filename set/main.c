@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "set.h"
 
@@ -6,34 +8,53 @@ enum set_operations {
     SET_CONTAINS = 1,
     SET_UNION,
     SET_INTERSECTION,
-    SET_REMOVE
+    SET_REMOVE,
+    SET_BATCH,
+    SET_DIFFERENCE,
+    SET_SYMMETRIC_DIFFERENCE,
+    SET_SNAPSHOT,
+    SET_FREEZE,
+    SET_REPEAT_UNION
 };
 
-int main(void)
+/* Lê `len` inteiros da entrada para um vetor alocado */
+static int *read_array(int len)
 {
+    int *vals = malloc((len > 0 ? len : 1) * sizeof *vals);
+
+    for (int i = 0; i < len; i++)
+        scanf("%d", &vals[i]);
+
+    return vals;
+}
+
+/* Lê `len` inteiros da entrada e monta um conjunto de uma vez com eles */
+static SET *read_set(enum set_type type, int len)
+{
+    int *vals = read_array(len);
+
+    SET *set = set_from_array(type, vals, len > 0 ? len : 0);
+
+    free(vals);
+
+    return set;
+}
+
+int main(int argc, char **argv)
+{
+    /* `-t n`: uniões e interseções de AVLs grandes usam até `n` threads */
+    if (argc == 3 && strcmp(argv[1], "-t") == 0)
+        set_threads(atoi(argv[2]));
+
     enum set_type type;
     int len_a, len_b;
 
     scanf("%d", &type);
 
-    SET *a = set_new(type);
-    SET *b = set_new(type);
-
     scanf("%d %d", &len_a, &len_b);
 
-    for (int i = 0; i < len_a; i++) {
-        int n;
-
-        scanf("%d", &n);
-        set_insert(a, n);
-    }
-    
-    for (int i = 0; i < len_b; i++) {
-        int n;
-
-        scanf("%d", &n);
-        set_insert(b, n);
-    }
+    SET *a = read_set(type, len_a);
+    SET *b = read_set(type, len_b);
 
     enum set_operations op;
     scanf("%d", &op);
@@ -69,6 +90,98 @@ int main(void)
             set_remove(a, n);
             set_print(a);
             
+            break;
+        }
+        case SET_DIFFERENCE:
+            c = set_difference(a, b);
+            set_print(c);
+
+            break;
+        case SET_SYMMETRIC_DIFFERENCE:
+            c = set_symmetric_difference(a, b);
+            set_print(c);
+
+            break;
+        case SET_SNAPSHOT: {
+            int removed, inserted;
+            scanf("%d %d", &removed, &inserted);
+
+            /* A nova versão perde `removed` e ganha `inserted`; `a` continua como estava */
+            c = set_snapshot(a);
+
+            set_remove(c, removed);
+            set_insert(c, inserted);
+
+            set_print(c);
+            set_print(a);
+
+            break;
+        }
+        case SET_FREEZE: {
+            int n;
+            scanf("%d", &n);
+
+            /* Depois de congelado, `a` responde às buscas mas recusa a inserção */
+            set_freeze(a);
+
+            if (set_contains(a, n))
+                puts("Pertence.");
+            else
+                puts("Nao pertence.");
+
+            set_insert(a, n);
+            set_print(a);
+
+            break;
+        }
+        case SET_REPEAT_UNION: {
+            int rounds;
+            scanf("%d", &rounds);
+
+            /* Une `a` várias vezes com conjuntos temporários novos, com os valores de
+             * `b`, liberados logo depois (junto com a união): a memória de `a` não
+             * pode crescer a cada rodada
+             */
+            int *vals = malloc((len_b > 0 ? len_b : 1) * sizeof *vals);
+            size_t n = 0, first = 0;
+
+            SET_ITER it;
+            set_iter_init(&it, b);
+
+            while (set_iter_next(&it, &vals[n]))
+                n++;
+
+            for (int i = 0; i < rounds; i++) {
+                SET *tmp = set_from_array(type, vals, n);
+
+                c = set_union(a, tmp);
+
+                set_free(&c);
+                set_free(&tmp);
+
+                if (i == 0)
+                    first = set_memory(a);
+            }
+
+            puts(set_memory(a) <= 2 * first ? "Memoria limitada." : "Memoria crescendo.");
+
+            free(vals);
+
+            break;
+        }
+        case SET_BATCH: {
+            int n_ins, n_del;
+            scanf("%d %d", &n_ins, &n_del);
+
+            int *ins = read_array(n_ins);
+            int *del = read_array(n_del);
+
+            set_apply_batch(a, ins, n_ins > 0 ? n_ins : 0, del, n_del > 0 ? n_del : 0);
+            set_print(a);
+
+            free(ins);
+            free(del);
+
             break;
         }
     }
@@ -0,0 +1,298 @@
+#include <stdint.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+#define POOL_ALIGN 64
+#define POOL_SLAB_SIZE 16384
+
+/* Objetos livres que um pool de ramo pega da origem de cada vez */
+#define POOL_BATCH 64
+
+/* Cabeçalho no começo de cada slab; os objetos começam no primeiro
+ * endereço alinhado a POOL_ALIGN depois dele.
+ */
+typedef struct pool_slab {
+    struct pool_slab *next;
+} POOL_SLAB;
+
+/* Objeto livre: os primeiros bytes guardam o próximo da lista */
+typedef struct pool_free_obj {
+    struct pool_free_obj *next;
+} POOL_FREE_OBJ;
+
+struct pool {
+    size_t size;
+
+    /* Referências para este pool, de árvores e de pools que encaminham para ele */
+    unsigned refs;
+
+    /* Depois de absorvido por `pool_merge`, o pool fica sem slabs e
+     * encaminha os pedidos para o pool que o absorveu.
+     */
+    struct pool *forward;
+
+    /* Os últimos de cada lista, para que `pool_merge` as emende em O(1) */
+    POOL_SLAB *slabs, *slabs_tail;
+    POOL_FREE_OBJ *free_list, *free_tail;
+
+    /* Região ainda não usada do slab mais novo */
+    char *cursor;
+    char *end;
+
+    /* Quantidade de slabs, para `pool_size` */
+    size_t slab_count;
+
+    /* Num pool criado por `pool_branch`, o pool de onde ele pega objetos
+     * livres; `lock` protege a lista livre da origem durante o fork-join.
+     */
+    struct pool *source;
+    pthread_mutex_t lock;
+};
+
+POOL *pool_new(size_t size)
+{
+    POOL *pool = malloc(sizeof *pool);
+
+    if (!pool)
+        return NULL;
+
+    // Todo objeto precisa caber um ponteiro (lista livre) e manter o alinhamento
+    if (size < sizeof(POOL_FREE_OBJ))
+        size = sizeof(POOL_FREE_OBJ);
+
+    pool->size = (size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+    pool->refs = 1;
+    pool->forward = NULL;
+    pool->slabs = pool->slabs_tail = NULL;
+    pool->free_list = pool->free_tail = NULL;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    pool->slab_count = 0;
+    pool->source = NULL;
+
+    pthread_mutex_init(&pool->lock, NULL);
+
+    return pool;
+}
+
+/* Solta uma referência para `pool`. Quando não sobra nenhuma, libera os
+ * slabs (ou, num pool que encaminha, a referência para o seguinte).
+ */
+static void pool_drop(POOL *pool)
+{
+    while (pool && --pool->refs == 0) {
+        POOL *next = pool->forward;
+        POOL_SLAB *slab = pool->slabs;
+
+        while (slab) {
+            POOL_SLAB *following = slab->next;
+
+            free(slab);
+            slab = following;
+        }
+
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+        pool = next;
+    }
+}
+
+/* Segue os encaminhamentos até o pool que tem os slabs, encurtando o
+ * caminho para as próximas chamadas.
+ */
+static POOL *pool_root(POOL *pool)
+{
+    while (pool->forward && pool->forward->forward) {
+        POOL *next = pool->forward;
+
+        next->forward->refs++;
+        pool->forward = next->forward;
+        pool_drop(next);
+    }
+
+    return pool->forward ? pool->forward : pool;
+}
+
+POOL *pool_ref(POOL *pool)
+{
+    pool->refs++;
+    return pool;
+}
+
+bool pool_exclusive(POOL *pool)
+{
+    return !pool->forward && pool->refs == 1;
+}
+
+static bool pool_grow(POOL *pool)
+{
+    // POOL_ALIGN a mais para poder alinhar o começo dos objetos
+    POOL_SLAB *slab = malloc(POOL_SLAB_SIZE + POOL_ALIGN);
+
+    if (!slab)
+        return false;
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    if (!pool->slabs_tail)
+        pool->slabs_tail = slab;
+
+    pool->slab_count++;
+
+    uintptr_t start = (uintptr_t)(slab + 1);
+    start = (start + POOL_ALIGN - 1) & ~(uintptr_t)(POOL_ALIGN - 1);
+
+    pool->cursor = (char *)start;
+    pool->end = (char *)slab + POOL_SLAB_SIZE + POOL_ALIGN;
+
+    return true;
+}
+
+POOL *pool_branch(POOL *parent)
+{
+    POOL *pool = pool_new(parent->size);
+
+    if (pool)
+        pool->source = parent->source ? parent->source : pool_root(parent);
+
+    return pool;
+}
+
+/* Passa para `pool`, que está com a lista livre vazia, até POOL_BATCH
+ * objetos livres da origem
+ */
+static void pool_refill(POOL *pool)
+{
+    POOL *source = pool->source;
+
+    pthread_mutex_lock(&source->lock);
+
+    POOL_FREE_OBJ *first = source->free_list;
+
+    if (first) {
+        POOL_FREE_OBJ *last = first;
+
+        for (int i = 1; i < POOL_BATCH && last->next; i++)
+            last = last->next;
+
+        source->free_list = last->next;
+
+        if (!source->free_list)
+            source->free_tail = NULL;
+
+        last->next = NULL;
+        pool->free_list = first;
+        pool->free_tail = last;
+    }
+
+    pthread_mutex_unlock(&source->lock);
+}
+
+void *pool_alloc(POOL *pool)
+{
+    pool = pool_root(pool);
+
+    // Um ramo só cria slabs próprios quando a origem também está sem objetos livres
+    if (!pool->free_list && pool->source && (size_t)(pool->end - pool->cursor) < pool->size)
+        pool_refill(pool);
+
+    if (pool->free_list) {
+        POOL_FREE_OBJ *obj = pool->free_list;
+
+        pool->free_list = obj->next;
+
+        if (!pool->free_list)
+            pool->free_tail = NULL;
+
+        return obj;
+    }
+
+    if ((size_t)(pool->end - pool->cursor) < pool->size && !pool_grow(pool))
+        return NULL;
+
+    void *obj = pool->cursor;
+    pool->cursor += pool->size;
+
+    return obj;
+}
+
+void pool_release(POOL *pool, void *ptr)
+{
+    if (!ptr)
+        return;
+
+    pool = pool_root(pool);
+
+    POOL_FREE_OBJ *obj = ptr;
+
+    obj->next = pool->free_list;
+    pool->free_list = obj;
+
+    if (!pool->free_tail)
+        pool->free_tail = obj;
+}
+
+void pool_merge(POOL *into, POOL **from)
+{
+    if (!from || !*from)
+        return;
+
+    POOL *dst = pool_root(into);
+    POOL *src = pool_root(*from);
+
+    if (src != dst) {
+        if (src->slabs) {
+            // Os slabs de `src` entram depois do atual, que continua sendo o da região livre
+            if (dst->slabs) {
+                src->slabs_tail->next = dst->slabs->next;
+                dst->slabs->next = src->slabs;
+
+                if (dst->slabs_tail == dst->slabs)
+                    dst->slabs_tail = src->slabs_tail;
+            } else {
+                dst->slabs = src->slabs;
+                dst->slabs_tail = src->slabs_tail;
+                dst->cursor = src->cursor;
+                dst->end = src->end;
+            }
+
+            dst->slab_count += src->slab_count;
+        }
+
+        if (src->free_list) {
+            src->free_tail->next = dst->free_list;
+            dst->free_list = src->free_list;
+
+            if (!dst->free_tail)
+                dst->free_tail = src->free_tail;
+        }
+
+        src->slabs = src->slabs_tail = NULL;
+        src->slab_count = 0;
+        src->free_list = src->free_tail = NULL;
+        src->cursor = NULL;
+        src->end = NULL;
+
+        // Quem ainda usa `src` passa a ser atendido por `dst`
+        src->forward = pool_ref(dst);
+    }
+
+    pool_drop(*from);
+    *from = NULL;
+}
+
+size_t pool_size(POOL *pool)
+{
+    return pool_root(pool)->slab_count * (POOL_SLAB_SIZE + POOL_ALIGN);
+}
+
+void pool_free(POOL **pool)
+{
+    if (!pool || !*pool)
+        return;
+
+    pool_drop(*pool);
+    *pool = NULL;
+}
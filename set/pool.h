@@ -0,0 +1,56 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct pool POOL;
+
+/* Cria um pool de objetos de `size` bytes. Os objetos vêm de slabs
+ * alinhados à linha de cache, e os liberados vão para uma lista livre.
+ */
+POOL *pool_new(size_t size);
+
+/* Retorna mais uma referência para o pool, para que outra árvore possa
+ * compartilhar objetos com as que já o usam. Cada referência é solta
+ * com `pool_free`.
+ */
+POOL *pool_ref(POOL *);
+
+/* Indica se só uma referência usa os slabs do pool, caso em que
+ * `pool_free` pode liberá-los sem visitar os objetos.
+ */
+bool pool_exclusive(POOL *);
+
+/* Cria um pool para um dos ramos de um fork-join sobre `parent`, usado por
+ * uma só thread. Sem objetos livres, ele pega um lote dos objetos livres da
+ * origem (sob um mutex) antes de criar slabs próprios, para que operações
+ * paralelas repetidas reaproveitem a memória já reservada. Deve voltar para
+ * `parent` por `pool_merge` depois do join.
+ */
+POOL *pool_branch(POOL *parent);
+
+/* Retorna um objeto do pool (reaproveita a lista livre antes de avançar
+ * no slab atual), ou `NULL` se faltar memória.
+ */
+void *pool_alloc(POOL *);
+
+/* Devolve um objeto ao pool, que poderá ser reutilizado por `pool_alloc`. */
+void pool_release(POOL *, void *);
+
+/* Move os slabs (e a lista livre) de `*from` para `into`, em O(1), e solta a
+ * referência `*from`. Usado quando nós de duas árvores passam a formar
+ * uma só. Se outras referências ainda usam `*from`, elas passam a usar
+ * os slabs de `into`.
+ */
+void pool_merge(POOL *into, POOL **from);
+
+/* Retorna quantos bytes os slabs do pool ocupam */
+size_t pool_size(POOL *);
+
+/* Solta uma referência. Na última, libera todos os slabs de uma vez,
+ * sem visitar objeto por objeto.
+ */
+void pool_free(POOL **);
+
+#endif
@@ -1,24 +1,21 @@
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "rb.h"
+#include "pool.h"
 
 #define BLACK(x) (!(x) || !(x)->is_red)
 #define BLACK_NONNULL(x) ((x) && !(x)->is_red)
 
 #define RED(x) ((x) && (x)->is_red)
 
-typedef struct rb_node {
-    bool is_red;
-    int value;
-
-    struct rb_node *left;
-    struct rb_node *right;
-} RB_NODE;
-
 struct rb_tree {
     RB_NODE *root;
     size_t len;
+
+    /* Slabs de onde saem os nós desta árvore */
+    POOL *pool;
 };
 
 RB_TREE *rb_tree_new(void)
@@ -27,6 +24,7 @@ RB_TREE *rb_tree_new(void)
 
     tree->root = NULL;
     tree->len = 0;
+    tree->pool = pool_new(sizeof(RB_NODE));
 
     return tree;
 }
@@ -39,10 +37,18 @@ size_t rb_tree_len(RB_TREE *tree)
     return tree->len;
 }
 
-/* Cria um nó, inicialmente vermelho */  
-static RB_NODE *rb_node_new(int value)
+size_t rb_tree_memory(RB_TREE *tree)
 {
-    RB_NODE *node = malloc(sizeof *node);
+    if (!tree)
+        return 0;
+
+    return sizeof *tree + pool_size(tree->pool);
+}
+
+/* Cria um nó no pool da árvore, inicialmente vermelho */  
+static RB_NODE *rb_node_new(POOL *pool, int value)
+{
+    RB_NODE *node = pool_alloc(pool);
 
     node->is_red = true;
     node->value = value;
@@ -52,6 +58,87 @@ static RB_NODE *rb_node_new(int value)
     return node;
 }
 
+/* Maior quantidade de nós de uma árvore 2-3 com altura negra `bh`,
+ * 3^bh - 1, saturada em SIZE_MAX.
+ */
+static size_t rb_max_nodes(int bh)
+{
+    size_t max = 1;
+
+    for (int i = 0; i < bh; i++) {
+        if (max > SIZE_MAX / 3)
+            return SIZE_MAX;
+
+        max *= 3;
+    }
+
+    return max - 1;
+}
+
+/* Monta, a partir dos `n` valores ordenados de `vals`, uma subárvore com
+ * raiz negra e altura negra exatamente `bh`, o que exige
+ * 2^bh - 1 <= n <= 3^bh - 1. A raiz vira um 2-nó quando os dois filhos
+ * comportam os n - 1 valores restantes, e um 3-nó (raiz negra com filho
+ * esquerdo vermelho) caso contrário, dividindo os valores por igual.
+ */
+static RB_NODE *rb_build_impl(POOL *pool, const int *vals, size_t n, int bh)
+{
+    if (n == 0)
+        return NULL;
+
+    size_t child_max = rb_max_nodes(bh - 1);
+
+    if (n - 1 - (n - 1) / 2 <= child_max) {
+        size_t left = (n - 1) / 2;
+        RB_NODE *root = rb_node_new(pool, vals[left]);
+
+        root->is_red = false;
+        root->left = rb_build_impl(pool, vals, left, bh - 1);
+        root->right = rb_build_impl(pool, vals + left + 1, n - 1 - left, bh - 1);
+
+        return root;
+    }
+
+    size_t first = (n - 2) / 3;
+    size_t second = (n - 2 - first) / 2;
+    size_t third = n - 2 - first - second;
+
+    RB_NODE *red = rb_node_new(pool, vals[first]);
+    RB_NODE *root = rb_node_new(pool, vals[first + 1 + second]);
+
+    red->left = rb_build_impl(pool, vals, first, bh - 1);
+    red->right = rb_build_impl(pool, vals + first + 1, second, bh - 1);
+
+    root->is_red = false;
+    root->left = red;
+    root->right = rb_build_impl(pool, vals + n - third, third, bh - 1);
+
+    return root;
+}
+
+/* Altura negra usada por `rb_build_impl` para `n` nós: a maior possível,
+ * floor(log2(n + 1)), que sempre comporta os n nós
+ */
+static int rb_sorted_black_height(size_t n)
+{
+    int bh = 0;
+
+    while (bh < 63 && ((size_t)2 << bh) - 1 <= n)
+        bh++;
+
+    return bh;
+}
+
+RB_TREE *rb_tree_from_sorted(const int *vals, size_t n)
+{
+    RB_TREE *tree = rb_tree_new();
+
+    tree->root = rb_build_impl(tree->pool, vals, n, rb_sorted_black_height(n));
+    tree->len = n;
+
+    return tree;
+}
+
 /* Inverte as cores do nó `node` e de seus filhos */
 static void rb_invert(RB_NODE *node)
 {
@@ -127,17 +214,17 @@ static RB_NODE *rb_fixup(RB_NODE *root)
  * `*inserted` caso a inserção tenha sido bem sucedida. A inserção irá falhar
  * caso um nó com valor `value` já exista na árvore.
  */
-static RB_NODE *rb_insert_impl(RB_NODE *root, int value, bool *inserted)
+static RB_NODE *rb_insert_impl(POOL *pool, RB_NODE *root, int value, bool *inserted)
 {
     if (!root) {
-        root = rb_node_new(value);
+        root = rb_node_new(pool, value);
         *inserted = true;
     }
 
     if (value < root->value)
-        root->left = rb_insert_impl(root->left, value, inserted);
+        root->left = rb_insert_impl(pool, root->left, value, inserted);
     else if (value > root->value)
-        root->right = rb_insert_impl(root->right, value, inserted);
+        root->right = rb_insert_impl(pool, root->right, value, inserted);
 
     return rb_fixup(root);
 }
@@ -149,7 +236,7 @@ bool rb_tree_insert(RB_TREE *tree, int value)
 
     bool inserted = false;
 
-    tree->root = rb_insert_impl(tree->root, value, &inserted);
+    tree->root = rb_insert_impl(tree->pool, tree->root, value, &inserted);
     tree->root->is_red = false;
 
     if (inserted)
@@ -204,7 +291,7 @@ static void rb_move_min(RB_NODE *node, RB_NODE *subtree)
 }
 
 /* Remove um nó com valor `value` da árvore com raiz em `root`, se existir. */ 
-static RB_NODE *rb_remove_impl(RB_NODE *root, int value, bool *removed)
+static RB_NODE *rb_remove_impl(POOL *pool, RB_NODE *root, int value, bool *removed)
 {
     if (!root)
         return NULL;
@@ -235,7 +322,7 @@ static RB_NODE *rb_remove_impl(RB_NODE *root, int value, bool *removed)
                 root->is_red = orphan->is_red;
 
             *removed = true;
-            free(orphan);
+            pool_release(pool, orphan);
         }
     }
 
@@ -255,12 +342,12 @@ static RB_NODE *rb_remove_impl(RB_NODE *root, int value, bool *removed)
         if (BLACK_NONNULL(root->right) && BLACK(root->right->left))
             root = rb_propagate_right(root);
 
-        root->right = rb_remove_impl(root->right, value, removed);
+        root->right = rb_remove_impl(pool, root->right, value, removed);
     } else if (value < root->value) {
         if (BLACK_NONNULL(root->left) && BLACK(root->left->left))
             root = rb_propagate_left(root);
 
-        root->left = rb_remove_impl(root->left, value, removed);
+        root->left = rb_remove_impl(pool, root->left, value, removed);
     }
 
     return rb_fixup(root);
@@ -273,7 +360,7 @@ bool rb_tree_remove(RB_TREE *tree, int value)
 
     bool removed = false;
 
-    tree->root = rb_remove_impl(tree->root, value, &removed);
+    tree->root = rb_remove_impl(tree->pool, tree->root, value, &removed);
 
     // A raiz pode não existir mais após uma remoção
     if (tree->root)
@@ -285,6 +372,430 @@ bool rb_tree_remove(RB_TREE *tree, int value)
     return removed;
 }
 
+/* Altura negra de `root`: quantidade de nós negros entre `root` (inclusive)
+ * e um `NULL`, a mesma por qualquer caminho.
+ */
+static int rb_black_height(RB_NODE *root)
+{
+    int bh = 0;
+
+    for (; root; root = root->left)
+        bh += !root->is_red;
+
+    return bh;
+}
+
+/* Pinta a raiz de negro, atualizando sua altura negra `*bh`. Uma subárvore
+ * LLRB com raiz negra continua válida, então pode ser usada por `rb_join`.
+ */
+static RB_NODE *rb_blacken(RB_NODE *root, int *bh)
+{
+    if (RED(root)) {
+        root->is_red = false;
+        (*bh)++;
+    }
+
+    return root;
+}
+
+/* Raiz de uma subárvore separada dos filhos, usada por split e join */
+typedef struct rb_parts {
+    RB_NODE *left;
+    int left_bh;
+
+    int value;
+
+    RB_NODE *right;
+    int right_bh;
+} RB_PARTS;
+
+/* Separa a raiz de `root` (com altura negra `bh`) dos seus filhos, que saem
+ * com raiz negra, e devolve o nó ao pool para ser reaproveitado pelo join.
+ */
+static RB_PARTS rb_take_root(POOL *pool, RB_NODE *root, int bh)
+{
+    int child_bh = bh - !root->is_red;
+
+    RB_PARTS parts = { root->left, child_bh, root->value, root->right, child_bh };
+
+    parts.left = rb_blacken(parts.left, &parts.left_bh);
+    parts.right = rb_blacken(parts.right, &parts.right_bh);
+
+    pool_release(pool, root);
+
+    return parts;
+}
+
+/* Desce pela direita de `left` até um nó negro com a altura negra de `right`
+ * e pendura ali um nó vermelho com `k`, como numa inserção; as correções de
+ * `rb_fixup` na volta restauram as condições da LLRB.
+ */
+static RB_NODE *rb_join_right(POOL *pool, RB_NODE *left, int left_bh, int k, RB_NODE *right, int right_bh)
+{
+    if (left_bh == right_bh && BLACK(left)) {
+        RB_NODE *node = rb_node_new(pool, k);
+
+        node->left = left;
+        node->right = right;
+
+        return node;
+    }
+
+    left->right = rb_join_right(pool, left->right, left_bh - !left->is_red, k, right, right_bh);
+
+    return rb_fixup(left);
+}
+
+/* Simétrica a `rb_join_right`, descendo pela esquerda de `right` */
+static RB_NODE *rb_join_left(POOL *pool, RB_NODE *left, int left_bh, int k, RB_NODE *right, int right_bh)
+{
+    if (left_bh == right_bh && BLACK(right)) {
+        RB_NODE *node = rb_node_new(pool, k);
+
+        node->left = left;
+        node->right = right;
+
+        return node;
+    }
+
+    right->left = rb_join_left(pool, left, left_bh, k, right->left, right_bh - !right->is_red);
+
+    return rb_fixup(right);
+}
+
+/* Junta `left` (valores menores que `k`), `k` e `right` (valores maiores),
+ * ambas com raiz negra e alturas negras `left_bh` e `right_bh`, em
+ * O(|left_bh - right_bh| + 1). O resultado tem raiz negra e altura negra `*bh`.
+ */
+static RB_NODE *rb_join(POOL *pool, RB_NODE *left, int left_bh, int k, RB_NODE *right, int right_bh, int *bh)
+{
+    RB_NODE *root;
+
+    if (left_bh > right_bh) {
+        root = rb_join_right(pool, left, left_bh, k, right, right_bh);
+        *bh = left_bh;
+    } else if (right_bh > left_bh) {
+        root = rb_join_left(pool, left, left_bh, k, right, right_bh);
+        *bh = right_bh;
+    } else {
+        root = rb_node_new(pool, k);
+        root->left = left;
+        root->right = right;
+        *bh = left_bh;
+    }
+
+    return rb_blacken(root, bh);
+}
+
+/* Resultado da divisão de uma árvore por um valor */
+typedef struct rb_split {
+    RB_NODE *left;
+    int left_bh;
+
+    RB_NODE *right;
+    int right_bh;
+
+    /* Se o valor usado na divisão estava na árvore */
+    bool present;
+} RB_SPLIT;
+
+/* Divide a árvore `root`, de altura negra `bh`, nos valores menores e
+ * maiores que `k`, ambas com raiz negra.
+ */
+static RB_SPLIT rb_split(POOL *pool, RB_NODE *root, int bh, int k)
+{
+    if (!root)
+        return (RB_SPLIT) { NULL, 0, NULL, 0, false };
+
+    RB_PARTS parts = rb_take_root(pool, root, bh);
+
+    if (k == parts.value)
+        return (RB_SPLIT) { parts.left, parts.left_bh, parts.right, parts.right_bh, true };
+
+    if (k < parts.value) {
+        RB_SPLIT result = rb_split(pool, parts.left, parts.left_bh, k);
+
+        result.right = rb_join(pool, result.right, result.right_bh, parts.value,
+                               parts.right, parts.right_bh, &result.right_bh);
+
+        return result;
+    } else {
+        RB_SPLIT result = rb_split(pool, parts.right, parts.right_bh, k);
+
+        result.left = rb_join(pool, parts.left, parts.left_bh, parts.value,
+                              result.left, result.left_bh, &result.left_bh);
+
+        return result;
+    }
+}
+
+/* Árvore sem o seu maior valor, usado por `rb_join_no_key` */
+typedef struct rb_split_last {
+    RB_NODE *root;
+    int bh;
+
+    int value;
+} RB_SPLIT_LAST;
+
+static RB_SPLIT_LAST rb_split_last(POOL *pool, RB_NODE *root, int bh)
+{
+    RB_PARTS parts = rb_take_root(pool, root, bh);
+
+    if (!parts.right)
+        return (RB_SPLIT_LAST) { parts.left, parts.left_bh, parts.value };
+
+    RB_SPLIT_LAST last = rb_split_last(pool, parts.right, parts.right_bh);
+
+    last.root = rb_join(pool, parts.left, parts.left_bh, parts.value, last.root, last.bh, &last.bh);
+
+    return last;
+}
+
+/* Junta `left` e `right` (todos os valores de `left` menores) sem valor intermediário */
+static RB_NODE *rb_join_no_key(POOL *pool, RB_NODE *left, int left_bh, RB_NODE *right, int right_bh, int *bh)
+{
+    if (!left) {
+        *bh = right_bh;
+        return right;
+    }
+
+    RB_SPLIT_LAST last = rb_split_last(pool, left, left_bh);
+
+    return rb_join(pool, last.root, last.bh, last.value, right, right_bh, bh);
+}
+
+/* Devolve ao pool os nós de uma subárvore descartada */
+static void rb_release_impl(POOL *pool, RB_NODE *root)
+{
+    if (!root)
+        return;
+
+    rb_release_impl(pool, root->left);
+    rb_release_impl(pool, root->right);
+
+    pool_release(pool, root);
+}
+
+/* União de `left` e `right` (raízes negras) por divisão e junção, em
+ * O(m log(n/m + 1)). Soma em `*common` os valores presentes nas duas.
+ */
+static RB_NODE *rb_union(POOL *pool, RB_NODE *left, int left_bh, RB_NODE *right, int right_bh,
+                         int *bh, size_t *common)
+{
+    if (!left) {
+        *bh = right_bh;
+        return right;
+    }
+
+    if (!right) {
+        *bh = left_bh;
+        return left;
+    }
+
+    RB_PARTS parts = rb_take_root(pool, right, right_bh);
+    RB_SPLIT split = rb_split(pool, left, left_bh, parts.value);
+
+    int lower_bh, upper_bh;
+    RB_NODE *lower = rb_union(pool, split.left, split.left_bh, parts.left, parts.left_bh, &lower_bh, common);
+    RB_NODE *upper = rb_union(pool, split.right, split.right_bh, parts.right, parts.right_bh, &upper_bh, common);
+
+    *common += split.present;
+
+    return rb_join(pool, lower, lower_bh, parts.value, upper, upper_bh, bh);
+}
+
+/* Interseção de `left` e `right` (raízes negras), nos moldes de `rb_union`.
+ * Soma em `*common` os valores que ficaram.
+ */
+static RB_NODE *rb_intersection(POOL *pool, RB_NODE *left, int left_bh, RB_NODE *right, int right_bh,
+                                int *bh, size_t *common)
+{
+    if (!left || !right) {
+        rb_release_impl(pool, left);
+        rb_release_impl(pool, right);
+
+        *bh = 0;
+        return NULL;
+    }
+
+    RB_PARTS parts = rb_take_root(pool, right, right_bh);
+    RB_SPLIT split = rb_split(pool, left, left_bh, parts.value);
+
+    int lower_bh, upper_bh;
+    RB_NODE *lower = rb_intersection(pool, split.left, split.left_bh, parts.left, parts.left_bh, &lower_bh, common);
+    RB_NODE *upper = rb_intersection(pool, split.right, split.right_bh, parts.right, parts.right_bh, &upper_bh, common);
+
+    if (split.present) {
+        (*common)++;
+        return rb_join(pool, lower, lower_bh, parts.value, upper, upper_bh, bh);
+    }
+
+    return rb_join_no_key(pool, lower, lower_bh, upper, upper_bh, bh);
+}
+
+/* Retira de `left` os valores presentes em `right` (raízes negras), cujos nós
+ * voltam ao pool. Soma em `*removed` quantos valores saíram de `left`.
+ */
+static RB_NODE *rb_difference(POOL *pool, RB_NODE *left, int left_bh, RB_NODE *right, int right_bh,
+                              int *bh, size_t *removed)
+{
+    if (!left || !right) {
+        rb_release_impl(pool, right);
+
+        *bh = left_bh;
+        return left;
+    }
+
+    RB_PARTS parts = rb_take_root(pool, right, right_bh);
+    RB_SPLIT split = rb_split(pool, left, left_bh, parts.value);
+
+    int lower_bh, upper_bh;
+    RB_NODE *lower = rb_difference(pool, split.left, split.left_bh, parts.left, parts.left_bh, &lower_bh, removed);
+    RB_NODE *upper = rb_difference(pool, split.right, split.right_bh, parts.right, parts.right_bh, &upper_bh, removed);
+
+    *removed += split.present;
+
+    return rb_join_no_key(pool, lower, lower_bh, upper, upper_bh, bh);
+}
+
+/* Diferença simétrica de `left` e `right` (raízes negras): os valores de
+ * apenas uma das duas. Soma em `*common` os valores presentes nas duas.
+ */
+static RB_NODE *rb_symmetric_difference(POOL *pool, RB_NODE *left, int left_bh, RB_NODE *right, int right_bh,
+                                        int *bh, size_t *common)
+{
+    if (!left) {
+        *bh = right_bh;
+        return right;
+    }
+
+    if (!right) {
+        *bh = left_bh;
+        return left;
+    }
+
+    RB_PARTS parts = rb_take_root(pool, right, right_bh);
+    RB_SPLIT split = rb_split(pool, left, left_bh, parts.value);
+
+    int lower_bh, upper_bh;
+    RB_NODE *lower = rb_symmetric_difference(pool, split.left, split.left_bh, parts.left, parts.left_bh,
+                                             &lower_bh, common);
+    RB_NODE *upper = rb_symmetric_difference(pool, split.right, split.right_bh, parts.right, parts.right_bh,
+                                             &upper_bh, common);
+
+    if (split.present) {
+        (*common)++;
+        return rb_join_no_key(pool, lower, lower_bh, upper, upper_bh, bh);
+    }
+
+    return rb_join(pool, lower, lower_bh, parts.value, upper, upper_bh, bh);
+}
+
+RB_TREE *rb_tree_union(RB_TREE **a, RB_TREE **b)
+{
+    int bh;
+    size_t common = 0;
+    RB_TREE *result = *a;
+
+    // Os nós de `b` passam a fazer parte de `a`
+    pool_merge(result->pool, &(*b)->pool);
+
+    result->root = rb_union(result->pool, result->root, rb_black_height(result->root),
+                            (*b)->root, rb_black_height((*b)->root), &bh, &common);
+    result->len += (*b)->len - common;
+
+    free(*b);
+    *b = NULL;
+    *a = NULL;
+
+    return result;
+}
+
+RB_TREE *rb_tree_intersection(RB_TREE **a, RB_TREE **b)
+{
+    int bh;
+    size_t common = 0;
+    RB_TREE *result = *a;
+
+    pool_merge(result->pool, &(*b)->pool);
+
+    result->root = rb_intersection(result->pool, result->root, rb_black_height(result->root),
+                                   (*b)->root, rb_black_height((*b)->root), &bh, &common);
+    result->len = common;
+
+    free(*b);
+    *b = NULL;
+    *a = NULL;
+
+    return result;
+}
+
+RB_TREE *rb_tree_difference(RB_TREE **a, RB_TREE **b)
+{
+    int bh;
+    size_t removed = 0;
+    RB_TREE *result = *a;
+
+    pool_merge(result->pool, &(*b)->pool);
+
+    result->root = rb_difference(result->pool, result->root, rb_black_height(result->root),
+                                 (*b)->root, rb_black_height((*b)->root), &bh, &removed);
+    result->len -= removed;
+
+    free(*b);
+    *b = NULL;
+    *a = NULL;
+
+    return result;
+}
+
+RB_TREE *rb_tree_symmetric_difference(RB_TREE **a, RB_TREE **b)
+{
+    int bh;
+    size_t common = 0;
+    RB_TREE *result = *a;
+
+    pool_merge(result->pool, &(*b)->pool);
+
+    result->root = rb_symmetric_difference(result->pool, result->root, rb_black_height(result->root),
+                                           (*b)->root, rb_black_height((*b)->root), &bh, &common);
+    result->len += (*b)->len - 2 * common;
+
+    free(*b);
+    *b = NULL;
+    *a = NULL;
+
+    return result;
+}
+
+void rb_tree_apply_sorted(RB_TREE *tree, const int *ins, size_t n_ins, const int *del, size_t n_del)
+{
+    if (!tree)
+        return;
+
+    // Cada lote vira uma árvore no pool da própria árvore, que entra por
+    // união e sai por diferença, em O(m log(n/m + 1))
+    int bh = rb_black_height(tree->root);
+
+    if (n_ins > 0) {
+        size_t common = 0;
+        int batch_bh = rb_sorted_black_height(n_ins);
+        RB_NODE *batch = rb_build_impl(tree->pool, ins, n_ins, batch_bh);
+
+        tree->root = rb_union(tree->pool, tree->root, bh, batch, batch_bh, &bh, &common);
+        tree->len += n_ins - common;
+    }
+
+    if (n_del > 0) {
+        size_t removed = 0;
+        int batch_bh = rb_sorted_black_height(n_del);
+        RB_NODE *batch = rb_build_impl(tree->pool, del, n_del, batch_bh);
+
+        tree->root = rb_difference(tree->pool, tree->root, bh, batch, batch_bh, &bh, &removed);
+        tree->len -= removed;
+    }
+}
+
 /* Realiza uma busca por `value` na árvore com raiz em `root`. Retorna o nó
  * caso seja encontrado, caso contrário, retorna `NULL`.
  */
@@ -327,15 +838,22 @@ void rb_tree_traverse(RB_TREE *tree, void (*cb)(int, void *), void *ctx)
     rb_traverse_impl(tree->root, cb, ctx);
 }
 
-RB_NODE *rb_clone_impl(RB_NODE *original)
+void rb_iter_init(RB_ITER *it, RB_TREE *tree)
+{
+    it->top = 0;
+    rb_iter_descend(it, tree ? tree->root : NULL);
+}
+
+static RB_NODE *rb_clone_impl(POOL *pool, RB_NODE *original)
 {
     if (!original)
         return NULL;
 
-    RB_NODE *clone = rb_node_new(original->value);
+    RB_NODE *clone = rb_node_new(pool, original->value);
 
-    clone->left = rb_clone_impl(original->left);
-    clone->right = rb_clone_impl(original->right);
+    clone->is_red = original->is_red;
+    clone->left = rb_clone_impl(pool, original->left);
+    clone->right = rb_clone_impl(pool, original->right);
 
     return clone;
 }
@@ -345,28 +863,18 @@ RB_TREE *rb_tree_clone(RB_TREE *tree)
     RB_TREE *clone = rb_tree_new();
 
     clone->len = tree->len;
-    clone->root = rb_clone_impl(tree->root);
+    clone->root = rb_clone_impl(clone->pool, tree->root);
 
     return clone;
 }
 
-static void rb_free_impl(RB_NODE *root)
-{
-    if (!root)
-        return;
-
-    rb_free_impl(root->left);
-    rb_free_impl(root->right);
-
-    free(root);
-}
-
+/* Os nós saem junto com os slabs do pool, sem percorrer a árvore */
 void rb_tree_free(RB_TREE **tree)
 {
     if (!tree || !*tree)
         return;
 
-    rb_free_impl((*tree)->root);
+    pool_free(&(*tree)->pool);
 
     free(*tree);
     *tree = NULL;
@@ -6,9 +6,38 @@
 
 typedef struct rb_tree RB_TREE;
 
+/* A altura de uma LLRB com n nós é no máximo 2 log2(n + 1), então 128
+ * posições bastam para qualquer árvore que caiba na memória.
+ */
+#define RB_ITER_DEPTH 128
+
+/* Nó da árvore. Fica visível para que `rb_iter_next` seja expandida em quem
+ * percorre a árvore; só rb.c cria e modifica nós.
+ */
+typedef struct rb_node {
+    bool is_red;
+    int value;
+
+    struct rb_node *left;
+    struct rb_node *right;
+} RB_NODE;
+
+/* Percurso em-ordem sem recursão nem alocação: a pilha guarda os nós
+ * cujo valor ainda não foi visitado.
+ */
+typedef struct rb_iter {
+    const RB_NODE *stack[RB_ITER_DEPTH];
+    int top;
+} RB_ITER;
+
 /* Cria uma árvore LLRB, inicialmente vazia */
 RB_TREE *rb_tree_new(void);
 
+/* Cria uma árvore LLRB com os `n` valores de `vals`, que devem estar em
+ * ordem estritamente crescente. Executa em O(n).
+ */
+RB_TREE *rb_tree_from_sorted(const int *vals, size_t n);
+
 /* Insere o valor `value` na árvore. Retorna `true` caso a inserção
  * tenha sido bem-sucedida.
  */
@@ -19,22 +48,71 @@ bool rb_tree_insert(RB_TREE *, int value);
  */ 
 bool rb_tree_remove(RB_TREE *, int value);
 
+/* Insere os `n_ins` valores de `ins` e depois remove os `n_del` valores de
+ * `del`, ambos em ordem estritamente crescente, por união e diferença com
+ * árvores montadas a partir dos lotes.
+ */
+void rb_tree_apply_sorted(RB_TREE *, const int *ins, size_t n_ins, const int *del, size_t n_del);
+
 /* Realiza uma busca por `value` na árvore. Retorna `true` caso o valor seja encontrado. */
 bool rb_tree_search(RB_TREE *, int value);
 
 /* Retorna o tamanho da árvore (quantidade de elementos) */
 size_t rb_tree_len(RB_TREE *);
 
+/* Retorna quantos bytes a árvore reserva (os slabs do seu pool) */
+size_t rb_tree_memory(RB_TREE *);
+
 /* Percorre a árvore em-ordem, chamando `cb` para cada nó e passando como argumentos
  * o valor do nó atual e o valor de `ctx`.
  */
 void rb_tree_traverse(RB_TREE *, void (*cb)(int value, void *ctx), void *ctx);
 
+/* Inicia um percurso em-ordem da árvore, que deixa de valer se ela for modificada */
+void rb_iter_init(RB_ITER *, RB_TREE *);
+
+/* Empilha `node` e os filhos à esquerda dele; o topo passa a ser o menor */
+static inline void rb_iter_descend(RB_ITER *it, const RB_NODE *node)
+{
+    for (; node; node = node->left)
+        it->stack[it->top++] = node;
+}
+
+/* Coloca em `*value` o próximo valor do percurso. Retorna `false` ao final. */
+static inline bool rb_iter_next(RB_ITER *it, int *value)
+{
+    if (it->top == 0)
+        return false;
+
+    const RB_NODE *node = it->stack[--it->top];
+    *value = node->value;
+    rb_iter_descend(it, node->right);
+
+    return true;
+}
+
 /* Clona a árvore, ou seja, retorna uma outra árvore com a
  * mesma estrutura e mesmos elementos, preservando a árvore original.
  */
 RB_TREE *rb_tree_clone(RB_TREE *);
 
+/* Calcula a união das árvores `*a` e `*b` por divisão e junção, em
+ * O(m log(n/m + 1)). As duas árvores são consumidas: o resultado
+ * reaproveita seus nós, e `*a` e `*b` passam a ser `NULL`.
+ */
+RB_TREE *rb_tree_union(RB_TREE **a, RB_TREE **b);
+
+/* Calcula a interseção de `*a` e `*b`, consumindo as duas como `rb_tree_union` */
+RB_TREE *rb_tree_intersection(RB_TREE **a, RB_TREE **b);
+
+/* Retira de `*a` os valores de `*b`, consumindo as duas como `rb_tree_union` */
+RB_TREE *rb_tree_difference(RB_TREE **a, RB_TREE **b);
+
+/* Calcula os valores que estão em apenas uma de `*a` e `*b`, consumindo as duas
+ * como `rb_tree_union`
+ */
+RB_TREE *rb_tree_symmetric_difference(RB_TREE **a, RB_TREE **b);
+
 /* Libera espaço ocupado pela árvore e nós. */
 void rb_tree_free(RB_TREE **);
 
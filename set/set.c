@@ -1,8 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "rb.h"
 #include "avl.h"
+#include "btree.h"
+#include "frozen.h"
+#include "bitmap.h"
+#include "hash.h"
 
 #include "set.h"
 
@@ -11,13 +16,20 @@ struct set {
     union {
         AVL_TREE *avl;
         RB_TREE *rb;
+        BTREE *btree;
+        FROZEN *frozen;
+        BITMAP *bitmap;
+        HASH *hash;
     } impl;
 };
 
-struct set_intersection_ctx {
-    SET *new;
-    SET *old;
-};
+/* Threads usadas por `set_union` e `set_intersection` */
+static int set_thread_count = 1;
+
+void set_threads(int threads)
+{
+    set_thread_count = threads > 1 ? threads : 1;
+}
 
 SET *set_new(enum set_type type)
 {
@@ -35,11 +47,122 @@ SET *set_new(enum set_type type)
         case SET_RB:
             set->impl.rb = rb_tree_new();
             break;
+        case SET_BTREE:
+            set->impl.btree = btree_new();
+            break;
+        case SET_FROZEN:
+            set->impl.frozen = frozen_from_sorted(NULL, 0);
+            break;
+        case SET_BITMAP:
+            set->impl.bitmap = bitmap_new();
+            break;
+        case SET_HASH:
+            set->impl.hash = hash_new();
+            break;
     }
 
     return set;
 }
 
+static int set_compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Deixa em `*run` os valores de `vals` em ordem estritamente crescente, e em `*n`
+ * quantos são. Se a entrada já estiver assim, `*run` aponta para ela mesma; senão
+ * para uma cópia ordenada e sem repetições em `*copy`, que deve ser liberada.
+ * Retorna `false` se faltar memória para a cópia.
+ */
+static bool set_sorted_run(const int *vals, size_t *n, const int **run, int **copy)
+{
+    /* Verifica se a entrada já é estritamente crescente (ou ao menos não-decrescente) */
+    bool increasing = true;
+    bool sorted = true;
+
+    for (size_t i = 1; i < *n && sorted; i++) {
+        if (vals[i - 1] >= vals[i])
+            increasing = false;
+
+        if (vals[i - 1] > vals[i])
+            sorted = false;
+    }
+
+    *run = vals;
+    *copy = NULL;
+
+    if (increasing)
+        return true;
+
+    *copy = malloc(*n * sizeof **copy);
+
+    if (!*copy)
+        return false;
+
+    memcpy(*copy, vals, *n * sizeof **copy);
+
+    if (!sorted)
+        qsort(*copy, *n, sizeof **copy, set_compare_int);
+
+    size_t len = 0;
+
+    for (size_t i = 0; i < *n; i++) {
+        if (len == 0 || (*copy)[len - 1] != (*copy)[i])
+            (*copy)[len++] = (*copy)[i];
+    }
+
+    *run = *copy;
+    *n = len;
+
+    return true;
+}
+
+SET *set_from_array(enum set_type type, const int *vals, size_t n)
+{
+    SET *set = malloc(sizeof *set);
+
+    if (!set)
+        return NULL;
+
+    int *copy;
+    const int *run;
+
+    if (!set_sorted_run(vals, &n, &run, &copy)) {
+        free(set);
+        return NULL;
+    }
+
+    set->type = type;
+
+    switch (set->type) {
+        case SET_AVL:
+            set->impl.avl = avl_tree_from_sorted(run, n);
+            break;
+        case SET_RB:
+            set->impl.rb = rb_tree_from_sorted(run, n);
+            break;
+        case SET_BTREE:
+            set->impl.btree = btree_from_sorted(run, n);
+            break;
+        case SET_FROZEN:
+            set->impl.frozen = frozen_from_sorted(run, n);
+            break;
+        case SET_BITMAP:
+            set->impl.bitmap = bitmap_from_sorted(run, n);
+            break;
+        case SET_HASH:
+            set->impl.hash = hash_from_sorted(run, n);
+            break;
+    }
+
+    free(copy);
+
+    return set;
+}
+
 bool set_insert(SET *set, int value)
 {
     if (!set)
@@ -50,6 +173,14 @@ bool set_insert(SET *set, int value)
             return avl_tree_insert(set->impl.avl, value);
         case SET_RB:
             return rb_tree_insert(set->impl.rb, value);
+        case SET_BTREE:
+            return btree_insert(set->impl.btree, value);
+        case SET_FROZEN:
+            return false;
+        case SET_BITMAP:
+            return bitmap_insert(set->impl.bitmap, value);
+        case SET_HASH:
+            return hash_insert(set->impl.hash, value);
     }
 
     return false;
@@ -65,11 +196,61 @@ bool set_remove(SET *set, int value)
             return avl_tree_remove(set->impl.avl, value);
         case SET_RB:
             return rb_tree_remove(set->impl.rb, value);
+        case SET_BTREE:
+            return btree_remove(set->impl.btree, value);
+        case SET_FROZEN:
+            return false;
+        case SET_BITMAP:
+            return bitmap_remove(set->impl.bitmap, value);
+        case SET_HASH:
+            return hash_remove(set->impl.hash, value);
     }
 
     return false;
 }
 
+bool set_apply_batch(SET *set, const int *ins, size_t n_ins, const int *del, size_t n_del)
+{
+    if (!set || set->type == SET_FROZEN)
+        return false;
+
+    int *ins_copy, *del_copy;
+    const int *ins_run, *del_run;
+
+    if (!set_sorted_run(ins, &n_ins, &ins_run, &ins_copy))
+        return false;
+
+    if (!set_sorted_run(del, &n_del, &del_run, &del_copy)) {
+        free(ins_copy);
+        return false;
+    }
+
+    switch (set->type) {
+        case SET_AVL:
+            avl_tree_apply_sorted(set->impl.avl, ins_run, n_ins, del_run, n_del);
+            break;
+        case SET_RB:
+            rb_tree_apply_sorted(set->impl.rb, ins_run, n_ins, del_run, n_del);
+            break;
+        case SET_BTREE:
+            btree_apply_sorted(set->impl.btree, ins_run, n_ins, del_run, n_del);
+            break;
+        case SET_FROZEN:
+            break;
+        case SET_BITMAP:
+            bitmap_apply_sorted(set->impl.bitmap, ins_run, n_ins, del_run, n_del);
+            break;
+        case SET_HASH:
+            hash_apply_sorted(set->impl.hash, ins_run, n_ins, del_run, n_del);
+            break;
+    }
+
+    free(ins_copy);
+    free(del_copy);
+
+    return true;
+}
+
 bool set_contains(SET *set, int value)
 {
     switch (set->type) {
@@ -77,6 +258,14 @@ bool set_contains(SET *set, int value)
             return avl_tree_search(set->impl.avl, value);
         case SET_RB:
             return rb_tree_search(set->impl.rb, value);
+        case SET_BTREE:
+            return btree_search(set->impl.btree, value);
+        case SET_FROZEN:
+            return frozen_search(set->impl.frozen, value);
+        case SET_BITMAP:
+            return bitmap_search(set->impl.bitmap, value);
+        case SET_HASH:
+            return hash_search(set->impl.hash, value);
     }
 
     return false;
@@ -89,15 +278,91 @@ static size_t set_len(SET *set)
             return avl_tree_len(set->impl.avl);
         case SET_RB:
             return rb_tree_len(set->impl.rb);
+        case SET_BTREE:
+            return btree_len(set->impl.btree);
+        case SET_FROZEN:
+            return frozen_len(set->impl.frozen);
+        case SET_BITMAP:
+            return bitmap_len(set->impl.bitmap);
+        case SET_HASH:
+            return hash_len(set->impl.hash);
     }
 
     return 0;
 }
 
-static void set_union_cb(int value, void *ctx)
+size_t set_memory(SET *set)
 {
-    SET *set = ctx;
-    set_insert(set, value);
+    if (!set)
+        return 0;
+
+    switch (set->type) {
+        case SET_AVL:
+            return sizeof *set + avl_tree_memory(set->impl.avl);
+        case SET_RB:
+            return sizeof *set + rb_tree_memory(set->impl.rb);
+        case SET_BTREE:
+            return sizeof *set + btree_memory(set->impl.btree);
+        case SET_FROZEN:
+            return sizeof *set + frozen_memory(set->impl.frozen);
+        case SET_BITMAP:
+            return sizeof *set + bitmap_memory(set->impl.bitmap);
+        case SET_HASH:
+            return sizeof *set + hash_memory(set->impl.hash);
+    }
+
+    return 0;
+}
+
+bool set_freeze(SET *set)
+{
+    if (!set)
+        return false;
+
+    if (set->type == SET_FROZEN)
+        return true;
+
+    size_t n = set_len(set);
+    int *vals = malloc((n ? n : 1) * sizeof *vals);
+
+    if (!vals)
+        return false;
+
+    SET_ITER it;
+    size_t i = 0;
+
+    set_iter_init(&it, set);
+
+    while (set_iter_next(&it, &vals[i]))
+        i++;
+
+    SET *frozen = set_from_array(SET_FROZEN, vals, n);
+    free(vals);
+
+    if (!frozen || !frozen->impl.frozen) {
+        free(frozen);
+        return false;
+    }
+
+    /* `set` fica com o vetor, e `frozen` leva embora a representação antiga */
+    SET tmp = *set;
+    *set = *frozen;
+    *frozen = tmp;
+
+    set_free(&frozen);
+
+    return true;
+}
+
+/* Piso de log2(n), com log2(0) = 0 */
+static size_t set_log2(size_t n)
+{
+    size_t log = 0;
+
+    while (n >>= 1)
+        log++;
+
+    return log;
 }
 
 static void set_clone_from(SET *clone, SET *original)
@@ -111,7 +376,112 @@ static void set_clone_from(SET *clone, SET *original)
         case SET_RB:
             clone->impl.rb = rb_tree_clone(original->impl.rb);
             break;
+        case SET_BTREE:
+            clone->impl.btree = btree_clone(original->impl.btree);
+            break;
+        case SET_FROZEN:
+            clone->impl.frozen = frozen_clone(original->impl.frozen);
+            break;
+        case SET_BITMAP:
+            clone->impl.bitmap = bitmap_clone(original->impl.bitmap);
+            break;
+        case SET_HASH:
+            clone->impl.hash = hash_clone(original->impl.hash);
+            break;
+    }
+}
+
+/* Até esta razão entre os tamanhos, percorrer os dois conjuntos juntos, em
+ * O(n + m), sai mais barato que as operações por busca ou por `split`
+ */
+#define SET_MERGE_RATIO 8
+
+void set_iter_init(SET_ITER *it, SET *set)
+{
+    it->type = set ? set->type : SET_AVL;
+
+    switch (it->type) {
+        case SET_AVL:
+            avl_iter_init(&it->impl.avl, set ? set->impl.avl : NULL);
+            break;
+        case SET_RB:
+            rb_iter_init(&it->impl.rb, set ? set->impl.rb : NULL);
+            break;
+        case SET_BTREE:
+            btree_iter_init(&it->impl.btree, set ? set->impl.btree : NULL);
+            break;
+        case SET_FROZEN:
+            frozen_iter_init(&it->impl.frozen, set ? set->impl.frozen : NULL);
+            break;
+        case SET_BITMAP:
+            bitmap_iter_init(&it->impl.bitmap, set ? set->impl.bitmap : NULL);
+            break;
+        case SET_HASH:
+            hash_iter_init(&it->impl.hash, set ? set->impl.hash : NULL);
+            break;
+    }
+}
+
+/* Quais valores a intercalação de `set_merge` mantém */
+enum set_merge_keep {
+    SET_KEEP_A = 1,     /* os que estão só no primeiro */
+    SET_KEEP_B = 2,     /* os que estão só no segundo */
+    SET_KEEP_BOTH = 4   /* os que estão nos dois */
+};
+
+/* Intercala `a` e `b`, de qualquer tipo, num novo conjunto do tipo `type` com os
+ * valores indicados por `keep`. Os valores saem em ordem, então o resultado é
+ * montado em O(n + m).
+ */
+static SET *set_merge(enum set_type type, SET *a, SET *b, size_t len_a, size_t len_b, unsigned keep)
+{
+    size_t cap = (keep & SET_KEEP_A ? len_a : 0) + (keep & SET_KEEP_B ? len_b : 0);
+
+    if (keep & SET_KEEP_BOTH)
+        cap += len_a < len_b ? len_a : len_b;
+
+    int *vals = malloc((cap ? cap : 1) * sizeof *vals);
+
+    if (!vals)
+        return NULL;
+
+    SET_ITER it_a, it_b;
+    int x, y;
+    size_t n = 0;
+
+    set_iter_init(&it_a, a);
+    set_iter_init(&it_b, b);
+
+    bool has_a = set_iter_next(&it_a, &x);
+    bool has_b = set_iter_next(&it_b, &y);
+
+    while (has_a && has_b) {
+        if (x < y) {
+            if (keep & SET_KEEP_A)
+                vals[n++] = x;
+            has_a = set_iter_next(&it_a, &x);
+        } else if (y < x) {
+            if (keep & SET_KEEP_B)
+                vals[n++] = y;
+            has_b = set_iter_next(&it_b, &y);
+        } else {
+            if (keep & SET_KEEP_BOTH)
+                vals[n++] = x;
+            has_a = set_iter_next(&it_a, &x);
+            has_b = set_iter_next(&it_b, &y);
+        }
     }
+
+    for (; (keep & SET_KEEP_A) && has_a; has_a = set_iter_next(&it_a, &x))
+        vals[n++] = x;
+
+    for (; (keep & SET_KEEP_B) && has_b; has_b = set_iter_next(&it_b, &y))
+        vals[n++] = y;
+
+    SET *c = set_from_array(type, vals, n);
+    free(vals);
+
+    return c;
 }
 
 SET *set_union(SET *a, SET *b)
@@ -121,6 +491,9 @@ SET *set_union(SET *a, SET *b)
     
     SET *c = malloc(sizeof *c);
 
+    if (!c)
+        return NULL;
+
     if (!a) {
         set_clone_from(c, b);
         return c;
@@ -131,17 +504,76 @@ SET *set_union(SET *a, SET *b)
         return c;
     }
 
-    /* Usa a implementação otimizada, que realiza a união em O(n) */
-    if (a->type == b->type && a->type == SET_AVL) {
+    size_t len_a = set_len(a);
+    size_t len_b = set_len(b);
+    size_t len_min = len_a < len_b ? len_a : len_b;
+    size_t len_max = len_a < len_b ? len_b : len_a;
+
+    /* Usa a implementação otimizada, que realiza a união em O(m log(n/m + 1)): as cópias
+     * da AVL são versões que dividem os nós com as originais, criadas em O(1), e a
+     * união copia apenas os caminhos que modifica. Com tamanhos parecidos e uma
+     * thread só, a intercalação abaixo é mais rápida.
+     */
+    bool similar = len_max <= SET_MERGE_RATIO * len_min;
+
+    /* Dois bitmaps são combinados bloco a bloco, palavra a palavra nos densos */
+    if (a->type == b->type && a->type == SET_BITMAP) {
+        c->type = SET_BITMAP;
+        c->impl.bitmap = bitmap_union(a->impl.bitmap, b->impl.bitmap);
+
+        return c;
+    }
+
+    /* Duas tabelas hash dispensam a ordem: a maior é copiada e recebe os valores da menor */
+    if (a->type == b->type && a->type == SET_HASH) {
+        c->type = SET_HASH;
+        c->impl.hash = hash_union(a->impl.hash, b->impl.hash);
+
+        return c;
+    }
+
+    /* A versão paralela só entra com mais de uma thread; com uma, a união por `split`
+     * é a sequencial, e só quando os tamanhos são bem diferentes
+     */
+    if (a->type == b->type && a->type == SET_AVL && (!similar || set_thread_count > 1)) {
         AVL_TREE *a_clone = avl_tree_clone(a->impl.avl);
         AVL_TREE *b_clone = avl_tree_clone(b->impl.avl);
 
         c->type = SET_AVL;
-        c->impl.avl = avl_tree_union(&a_clone, &b_clone);
+        c->impl.avl = set_thread_count > 1 ? avl_tree_union_parallel(&a_clone, &b_clone, set_thread_count)
+                                           : avl_tree_union(&a_clone, &b_clone);
 
         return c;
     }
-    
+
+    /* A LLRB não divide nós entre versões, então as cópias que a união por `split`
+     * consome custam O(n + m); ainda assim, com tamanhos bem diferentes, copiar e
+     * juntar sai mais barato que montar o resultado valor a valor.
+     */
+    if (a->type == b->type && a->type == SET_RB && !similar) {
+        RB_TREE *a_clone = rb_tree_clone(a->impl.rb);
+        RB_TREE *b_clone = rb_tree_clone(b->impl.rb);
+
+        c->type = SET_RB;
+        c->impl.rb = rb_tree_union(&a_clone, &b_clone);
+
+        return c;
+    }
+
+    /* Nos demais casos é preciso ler os dois conjuntos inteiros de qualquer forma (para
+     * clonar o maior conjunto, na união ingênua), então intercalar os dois, em
+     * O(n + m), nunca perde. O resultado tem o tipo do maior.
+     */
+    free(c);
+
+    return set_merge(len_b < len_a ? a->type : b->type, a, b, len_a, len_b, SET_KEEP_A | SET_KEEP_B | SET_KEEP_BOTH);
+}
+
+SET *set_intersection(SET *a, SET *b)
+{
+    if (!a || !b)
+        return NULL;
+
     /* Fixaremos `a` como o conjunto com a menor quantidade de elementos */
     size_t len_a = set_len(a);
     size_t len_b = set_len(b);
@@ -150,75 +582,387 @@ SET *set_union(SET *a, SET *b)
         SET *tmp = a;
         a = b;
         b = tmp;
+
+        size_t len_tmp = len_a;
+        len_a = len_b;
+        len_b = len_tmp;
     }
 
-    /* A implementação ingênua realiza união em O(n + m * log(n + m)) */
-    set_clone_from(c, b);
-    
-    switch (a->type) {
+    /* Na AVL, as cópias que a interseção por `split` consome custam O(1) (dividem os
+     * nós com as originais), então ela sempre leva O(m log(n/m + 1)); só perde para a
+     * intercalação em O(n + m) quando os tamanhos são parecidos e há uma thread só.
+     */
+    bool similar = len_b <= SET_MERGE_RATIO * len_a;
+
+    if (a->type == b->type && a->type == SET_BITMAP) {
+        BITMAP *result = bitmap_intersection(a->impl.bitmap, b->impl.bitmap);
+        SET *c = malloc(sizeof *c);
+
+        if (!c) {
+            bitmap_free(&result);
+            return NULL;
+        }
+
+        c->type = SET_BITMAP;
+        c->impl.bitmap = result;
+
+        return c;
+    }
+
+    if (a->type == b->type && a->type == SET_HASH) {
+        HASH *result = hash_intersection(a->impl.hash, b->impl.hash);
+        SET *c = malloc(sizeof *c);
+
+        if (!c) {
+            hash_free(&result);
+            return NULL;
+        }
+
+        c->type = SET_HASH;
+        c->impl.hash = result;
+
+        return c;
+    }
+
+    /* Como na união, a versão paralela só entra com mais de uma thread */
+    if (a->type == b->type && a->type == SET_AVL && (!similar || set_thread_count > 1)) {
+        SET *c = malloc(sizeof *c);
+
+        if (!c)
+            return NULL;
+
+        AVL_TREE *a_clone = avl_tree_clone(a->impl.avl);
+        AVL_TREE *b_clone = avl_tree_clone(b->impl.avl);
+
+        c->type = SET_AVL;
+        c->impl.avl = set_thread_count > 1 ? avl_tree_intersection_parallel(&a_clone, &b_clone, set_thread_count)
+                                           : avl_tree_intersection(&a_clone, &b_clone);
+
+        return c;
+    }
+
+    /* Nos demais casos, buscar cada valor de `a` em `b` leva O(m * log(n)), com n >= m,
+     * enquanto intercalar os dois conjuntos leva O(n + m). Intercala quando `m` não é
+     * muito menor que `n`. A interseção por `split` da LLRB (`rb_tree_intersection`)
+     * não entra aqui: ela consome as árvores, e só a cópia de `b` já custaria O(n). Numa tabela hash a busca leva O(1), e a intercalação ainda teria de
+     * ordená-la, então ela é sempre consultada por busca.
+     */
+    if (b->type != SET_HASH && len_a * set_log2(len_b) > len_a + len_b)
+        return set_merge(a->type, a, b, len_a, len_b, SET_KEEP_BOTH);
+
+    /* Os valores encontrados saem em ordem, e o resultado é montado de uma vez */
+    int *vals = malloc((len_a ? len_a : 1) * sizeof *vals);
+
+    if (!vals)
+        return NULL;
+
+    SET_ITER it;
+    int value;
+    size_t n = 0;
+
+    set_iter_init(&it, a);
+
+    while (set_iter_next(&it, &value)) {
+        if (set_contains(b, value))
+            vals[n++] = value;
+    }
+
+    SET *c = set_from_array(a->type, vals, n);
+    free(vals);
+
+    return c;
+}
+
+static void set_difference_cb(int value, void *ctx)
+{
+    SET *set = ctx;
+    set_remove(set, value);
+}
+
+static void set_symmetric_difference_cb(int value, void *ctx)
+{
+    SET *set = ctx;
+
+    if (!set_remove(set, value))
+        set_insert(set, value);
+}
+
+/* Aplica `cb` em `a` para cada valor de `b`, usado quando os tipos diferem */
+static void set_apply_each(SET *a, SET *b, void (*cb)(int, void *))
+{
+    switch (b->type) {
         case SET_AVL:
-            avl_tree_traverse(a->impl.avl, set_union_cb, c);
+            avl_tree_traverse(b->impl.avl, cb, a);
             break;
         case SET_RB:
-            rb_tree_traverse(a->impl.rb, set_union_cb, c);
+            rb_tree_traverse(b->impl.rb, cb, a);
+            break;
+        case SET_BTREE:
+            btree_traverse(b->impl.btree, cb, a);
+            break;
+        case SET_FROZEN:
+            frozen_traverse(b->impl.frozen, cb, a);
+            break;
+        case SET_BITMAP:
+            bitmap_traverse(b->impl.bitmap, cb, a);
+            break;
+        case SET_HASH:
+            hash_traverse(b->impl.hash, cb, a);
             break;
     }
+}
 
-    return c;
+/* Troca o conteúdo de `a` pela intercalação de `a` e `b` */
+static void set_merge_into(SET *a, SET *b, unsigned keep)
+{
+    SET *c = set_merge(a->type, a, b, set_len(a), set_len(b), keep);
+
+    if (!c)
+        return;
+
+    SET tmp = *a;
+    *a = *c;
+    *c = tmp;
+
+    set_free(&c);
 }
 
-static void set_intersection_cb(int value, void *ctx)
+void set_difference_inplace(SET *a, SET **b)
 {
-    struct set_intersection_ctx *sets = ctx;
+    if (!a || !b || !*b)
+        return;
 
-    if (set_contains(sets->old, value))
-        set_insert(sets->new, value);
+    /* Com o mesmo tipo, os nós de `b` são reaproveitados pela divisão e junção */
+    if (a->type == (*b)->type && a->type == SET_AVL) {
+        a->impl.avl = avl_tree_difference(&a->impl.avl, &(*b)->impl.avl);
+
+        free(*b);
+        *b = NULL;
+
+        return;
+    }
+
+    if (a->type == (*b)->type && a->type == SET_RB) {
+        a->impl.rb = rb_tree_difference(&a->impl.rb, &(*b)->impl.rb);
+
+        free(*b);
+        *b = NULL;
+
+        return;
+    }
+
+    if (a->type == (*b)->type && a->type == SET_BITMAP) {
+        BITMAP *c = bitmap_difference(a->impl.bitmap, (*b)->impl.bitmap);
+
+        bitmap_free(&a->impl.bitmap);
+        a->impl.bitmap = c;
+
+        set_free(b);
+
+        return;
+    }
+
+    if (a->type == (*b)->type && a->type == SET_HASH) {
+        hash_difference_inplace(a->impl.hash, (*b)->impl.hash);
+        set_free(b);
+
+        return;
+    }
+
+    /* A árvore B+ com outra árvore B+, e o conjunto congelado (que não aceita remoções)
+     * com qualquer outro, são refeitos pela intercalação dos dois; nos demais casos, os
+     * valores de `b` são removidos um a um
+     */
+    if (a->type == (*b)->type || a->type == SET_FROZEN)
+        set_merge_into(a, *b, SET_KEEP_A);
+    else
+        set_apply_each(a, *b, set_difference_cb);
+
+    set_free(b);
 }
 
-SET *set_intersection(SET *a, SET *b)
+void set_symmetric_difference_inplace(SET *a, SET **b)
 {
-    if (!a || !b)
-        return NULL;
+    if (!a || !b || !*b)
+        return;
 
-    /* Fixaremos `a` como o conjunto com a menor quantidade de elementos */
-    size_t len_a = set_len(a);
-    size_t len_b = set_len(b);
+    if (a->type == (*b)->type && a->type == SET_AVL) {
+        a->impl.avl = avl_tree_symmetric_difference(&a->impl.avl, &(*b)->impl.avl);
 
-    if (len_b < len_a) {
-        SET *tmp = a;
-        a = b;
-        b = tmp;
+        free(*b);
+        *b = NULL;
+
+        return;
+    }
+
+    if (a->type == (*b)->type && a->type == SET_RB) {
+        a->impl.rb = rb_tree_symmetric_difference(&a->impl.rb, &(*b)->impl.rb);
+
+        free(*b);
+        *b = NULL;
+
+        return;
     }
 
-    /* Como devemos manter as árvores originais intactas, a implementação de interseção
-     * usando `join` e `split` seria mais ineficiente que a implementação "ingênua":
-     * Apenas clonar as árvores já levaria O(n + m), enquanto o algoritmo "ingênuo" 
-     * de interseção leva O(m * (log(n) + log(m))) = O(m * log(n * m)), com n >= m.
+    if (a->type == (*b)->type && a->type == SET_BITMAP) {
+        BITMAP *c = bitmap_symmetric_difference(a->impl.bitmap, (*b)->impl.bitmap);
+
+        bitmap_free(&a->impl.bitmap);
+        a->impl.bitmap = c;
+
+        set_free(b);
+
+        return;
+    }
+
+    if (a->type == (*b)->type && a->type == SET_HASH) {
+        hash_symmetric_difference_inplace(a->impl.hash, (*b)->impl.hash);
+        set_free(b);
+
+        return;
+    }
+
+    if (a->type == (*b)->type || a->type == SET_FROZEN)
+        set_merge_into(a, *b, SET_KEEP_A | SET_KEEP_B);
+    else
+        set_apply_each(a, *b, set_symmetric_difference_cb);
+
+    set_free(b);
+}
+
+/* Clona `original` num novo conjunto */
+static SET *set_clone(SET *original)
+{
+    SET *clone = malloc(sizeof *clone);
+
+    if (clone)
+        set_clone_from(clone, original);
+
+    return clone;
+}
+
+SET *set_snapshot(SET *set)
+{
+    if (!set)
+        return NULL;
+
+    return set_clone(set);
+}
+
+SET *set_difference(SET *a, SET *b)
+{
+    if (!a)
+        return NULL;
+
+    if (!b)
+        return set_clone(a);
+
+    /* Nos casos em que a versão destrutiva intercala os dois conjuntos, a intercalação
+     * lê `a` e `b` direto, sem clones
      */
-    SET *c = set_new(a->type);
+    if (a->type == SET_FROZEN || (a->type == b->type && a->type == SET_BTREE))
+        return set_merge(a->type, a, b, set_len(a), set_len(b), SET_KEEP_A);
 
-    struct set_intersection_ctx ctx = {
-        .old = b,
-        .new = c,
-    };
+    /* Dois bitmaps são combinados sem ser modificados, então também dispensam clones */
+    if (a->type == b->type && a->type == SET_BITMAP) {
+        BITMAP *result = bitmap_difference(a->impl.bitmap, b->impl.bitmap);
+        SET *c = malloc(sizeof *c);
 
-    switch (a->type) {
-        case SET_AVL:
-            avl_tree_traverse(a->impl.avl, set_intersection_cb, &ctx);
-            break;
-        case SET_RB:
-            rb_tree_traverse(a->impl.rb, set_intersection_cb, &ctx);
-            break;
+        if (!c) {
+            bitmap_free(&result);
+            return NULL;
+        }
+
+        c->type = SET_BITMAP;
+        c->impl.bitmap = result;
+
+        return c;
+    }
+
+    if (a->type == b->type && a->type == SET_HASH) {
+        HASH *result = hash_difference(a->impl.hash, b->impl.hash);
+        SET *c = malloc(sizeof *c);
+
+        if (!c) {
+            hash_free(&result);
+            return NULL;
+        }
+
+        c->type = SET_HASH;
+        c->impl.hash = result;
+
+        return c;
+    }
+
+    SET *c = set_clone(a);
+
+    /* Com tipos iguais, a diferença por `split` consome um clone de `b`; senão,
+     * os valores de `b` são removidos um a um
+     */
+    if (a->type == b->type) {
+        SET *b_clone = set_clone(b);
+        set_difference_inplace(c, &b_clone);
+    } else {
+        set_apply_each(c, b, set_difference_cb);
     }
 
     return c;
 }
 
-void set_print_cb(int value, void *ctx)
+SET *set_symmetric_difference(SET *a, SET *b)
 {
-    (void)ctx;
-    
-    printf("%d, ", value);
+    if (!a && !b)
+        return NULL;
+
+    if (!a)
+        return set_clone(b);
+
+    if (!b)
+        return set_clone(a);
+
+    if (a->type == SET_FROZEN || (a->type == b->type && a->type == SET_BTREE))
+        return set_merge(a->type, a, b, set_len(a), set_len(b), SET_KEEP_A | SET_KEEP_B);
+
+    if (a->type == b->type && a->type == SET_BITMAP) {
+        BITMAP *result = bitmap_symmetric_difference(a->impl.bitmap, b->impl.bitmap);
+        SET *c = malloc(sizeof *c);
+
+        if (!c) {
+            bitmap_free(&result);
+            return NULL;
+        }
+
+        c->type = SET_BITMAP;
+        c->impl.bitmap = result;
+
+        return c;
+    }
+
+    if (a->type == b->type && a->type == SET_HASH) {
+        HASH *result = hash_symmetric_difference(a->impl.hash, b->impl.hash);
+        SET *c = malloc(sizeof *c);
+
+        if (!c) {
+            hash_free(&result);
+            return NULL;
+        }
+
+        c->type = SET_HASH;
+        c->impl.hash = result;
+
+        return c;
+    }
+
+    SET *c = set_clone(a);
+
+    if (a->type == b->type) {
+        SET *b_clone = set_clone(b);
+        set_symmetric_difference_inplace(c, &b_clone);
+    } else {
+        set_apply_each(c, b, set_symmetric_difference_cb);
+    }
+
+    return c;
 }
 
 void set_print(SET *set)
@@ -226,14 +970,13 @@ void set_print(SET *set)
     if (!set)
         return;
 
-    switch (set->type) {
-        case SET_AVL:
-            avl_tree_traverse(set->impl.avl, set_print_cb, NULL);
-            break;
-        case SET_RB:
-            rb_tree_traverse(set->impl.rb, set_print_cb, NULL);
-            break;
-    }
+    SET_ITER it;
+    int value;
+
+    set_iter_init(&it, set);
+
+    while (set_iter_next(&it, &value))
+        printf("%d, ", value);
 
     fputc('\n', stdout);
 }
@@ -250,7 +993,20 @@ void set_free(SET **set)
         case SET_RB:
             rb_tree_free(&(*set)->impl.rb);
             break;
+        case SET_BTREE:
+            btree_free(&(*set)->impl.btree);
+            break;
+        case SET_FROZEN:
+            frozen_free(&(*set)->impl.frozen);
+            break;
+        case SET_BITMAP:
+            bitmap_free(&(*set)->impl.bitmap);
+            break;
+        case SET_HASH:
+            hash_free(&(*set)->impl.hash);
+            break;
     }
 
+    free(*set);
     *set = NULL;
 }
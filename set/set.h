@@ -2,24 +2,146 @@
 #define SET_H
 
 #include <stdbool.h>
+#include <stddef.h>
+
+#include "avl.h"
+#include "rb.h"
+#include "btree.h"
+#include "frozen.h"
+#include "bitmap.h"
+#include "hash.h"
 
 typedef struct set SET;
 
 enum set_type {
     SET_AVL,
-    SET_RB
+    SET_RB,
+
+    /* Árvore B+ com nós do tamanho de algumas linhas de cache e folhas
+     * encadeadas: buscas mais rápidas em conjuntos grandes
+     */
+    SET_BTREE,
+
+    /* Só leitura, criado por `set_freeze` (ou direto por `set_from_array`):
+     * um vetor em ordem de Eytzinger, com buscas sem desvios
+     */
+    SET_FROZEN,
+
+    /* Bitmap comprimido em blocos de 2^16 valores, cada um em vetor, mapa de
+     * bits ou intervalos: pouca memória para faixas densas de inteiros
+     */
+    SET_BITMAP,
+
+    /* Tabela hash com endereçamento aberto: buscas em O(1) esperado, e a ordem
+     * só é calculada (e guardada) quando o conjunto é percorrido
+     */
+    SET_HASH
 };
 
 SET *set_new(enum set_type type);
 
+/* Cria um conjunto com os `n` valores de `vals`, em qualquer ordem e
+ * possivelmente repetidos. Entradas já ordenadas são montadas em O(n).
+ */
+SET *set_from_array(enum set_type type, const int *vals, size_t n);
+
+/* Retorna uma nova versão do conjunto, independente da original. Em conjuntos
+ * `SET_AVL` custa O(1): as duas versões dividem os nós, e cada atualização copia
+ * apenas o caminho que modifica. Versões que dividem nós podem ser lidas em
+ * paralelo, mas atualizadas e liberadas por uma thread de cada vez.
+ * Nos demais tipos, o conjunto é clonado.
+ */
+SET *set_snapshot(SET *);
+
 bool set_contains(SET *, int value);
 
+/* Retorna quantos bytes o conjunto reserva. Nas árvores, é o tamanho dos slabs
+ * do pool, contando os nós livres e os que as versões de `set_snapshot` dividem.
+ */
+size_t set_memory(SET *);
+
+/* Converte o conjunto para `SET_FROZEN`, otimizado para `set_contains`. Percursos,
+ * `set_print` e as operações entre conjuntos continuam iguais, e entre dois conjuntos
+ * congelados a união e a interseção intercalam os vetores. Depois disso, `set_insert`,
+ * `set_remove` e `set_apply_batch` recusam modificações e retornam `false`.
+ * Retorna `false` se faltar memória, caso em que o conjunto fica como estava.
+ */
+bool set_freeze(SET *);
+
 bool set_insert(SET *, int value);
 bool set_remove(SET *, int value);
 
+/* Insere os `n_ins` valores de `ins` e depois remove os `n_del` valores de
+ * `del` (um valor presente nos dois lotes fica de fora). Os lotes podem vir
+ * em qualquer ordem e com repetições. Retorna `false` se faltar memória.
+ */
+bool set_apply_batch(SET *, const int *ins, size_t n_ins, const int *del, size_t n_del);
+
 SET *set_union(SET *, SET *);
 SET *set_intersection(SET *, SET *);
 
+/* Retorna um novo conjunto com os valores do primeiro que não estão no segundo */
+SET *set_difference(SET *, SET *);
+
+/* Retorna um novo conjunto com os valores que estão em apenas um dos dois */
+SET *set_symmetric_difference(SET *, SET *);
+
+/* Versões destrutivas: `a` passa a ser o resultado e `*b` é consumido
+ * (passa a ser `NULL`). Com árvores AVL ou LLRB do mesmo tipo, os nós de
+ * `b` são reaproveitados, sem nenhuma alocação.
+ */
+void set_difference_inplace(SET *a, SET **b);
+void set_symmetric_difference_inplace(SET *a, SET **b);
+
+/* Define quantas threads `set_union` e `set_intersection` podem usar
+ * (1 por padrão). Por enquanto, só conjuntos `SET_AVL` se beneficiam.
+ */
+void set_threads(int threads);
+
+/* Percurso em ordem crescente sem alocação: a pilha de cada árvore tem tamanho
+ * fixo, dado pela altura máxima, e o iterador pode ficar na pilha de quem chama.
+ * A exceção é a tabela hash, que ordena seus valores na primeira vez. Deixa de
+ * valer se o conjunto for modificado durante o percurso.
+ */
+typedef struct set_iter {
+    enum set_type type;
+    union {
+        AVL_ITER avl;
+        RB_ITER rb;
+        BTREE_ITER btree;
+        FROZEN_ITER frozen;
+        BITMAP_ITER bitmap;
+        HASH_ITER hash;
+    } impl;
+} SET_ITER;
+
+void set_iter_init(SET_ITER *, SET *);
+
+/* Coloca em `*value` o próximo valor do conjunto. Retorna `false` ao final.
+ * Os passos de cada tipo também estão nos cabeçalhos, então um laço como o da
+ * intercalação em set.c fica sem chamadas por valor; só o do bitmap, que
+ * depende do formato de cada bloco, continua em bitmap.c.
+ */
+static inline bool set_iter_next(SET_ITER *it, int *value)
+{
+    switch (it->type) {
+        case SET_AVL:
+            return avl_iter_next(&it->impl.avl, value);
+        case SET_RB:
+            return rb_iter_next(&it->impl.rb, value);
+        case SET_BTREE:
+            return btree_iter_next(&it->impl.btree, value);
+        case SET_FROZEN:
+            return frozen_iter_next(&it->impl.frozen, value);
+        case SET_BITMAP:
+            return bitmap_iter_next(&it->impl.bitmap, value);
+        case SET_HASH:
+            return hash_iter_next(&it->impl.hash, value);
+    }
+
+    return false;
+}
+
 void set_print(SET *);
 
 void set_free(SET **);
@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trabalhadores.h"
+
+#include<stdlib.h>
+#include<pthread.h>
+#include<unistd.h>
+
+struct trabalhadores{
+   pthread_mutex_t trava;
+   pthread_cond_t tem_tarefa;
+   pthread_cond_t tem_vaga;
+
+   void **fila;      //fila circular de tarefas
+   int capacidade;
+   int inicio;
+   int quantidade;
+   bool encerrando;
+
+   TAREFA executar;
+   pthread_t *threads;
+   int n_threads;
+};
+
+static void *trabalhador(void *arg){
+   TRABALHADORES *t = (TRABALHADORES*) arg;
+   CAIXEIRO_AREA *area = caixeiro_area_criar();
+
+   while(1){
+      pthread_mutex_lock(&t->trava);
+      while(t->quantidade == 0 && !t->encerrando) pthread_cond_wait(&t->tem_tarefa, &t->trava);
+
+      if(t->quantidade == 0){ //encerrando e sem nada pendente
+         pthread_mutex_unlock(&t->trava);
+         break;
+      }
+
+      void *tarefa = t->fila[t->inicio];
+      t->inicio = (t->inicio + 1) % t->capacidade;
+      t->quantidade--;
+
+      pthread_cond_signal(&t->tem_vaga);
+      pthread_mutex_unlock(&t->trava);
+
+      t->executar(tarefa, area);
+   }
+
+   caixeiro_area_apagar(&area);
+   return NULL;
+}
+
+TRABALHADORES *trabalhadores_criar(int threads, int capacidade, TAREFA executar){
+   if(threads <= 0 || capacidade <= 0 || executar == NULL) return NULL;
+
+   TRABALHADORES *t = (TRABALHADORES*) calloc(1, sizeof(TRABALHADORES));
+   if(t == NULL) return NULL;
+
+   t->fila = (void**) malloc(capacidade * sizeof(void*));
+   t->threads = (pthread_t*) malloc(threads * sizeof(pthread_t));
+   if(t->fila == NULL || t->threads == NULL){
+      free(t->fila); free(t->threads); free(t);
+      return NULL;
+   }
+
+   pthread_mutex_init(&t->trava, NULL);
+   pthread_cond_init(&t->tem_tarefa, NULL);
+   pthread_cond_init(&t->tem_vaga, NULL);
+   t->capacidade = capacidade;
+   t->executar = executar;
+
+   for(int i = 0; i < threads; i++){
+      if(pthread_create(&t->threads[t->n_threads], NULL, trabalhador, t) == 0) t->n_threads++;
+   }
+
+   if(t->n_threads == 0){
+      trabalhadores_apagar(&t);
+      return NULL;
+   }
+   return t;
+}
+
+bool trabalhadores_enviar(TRABALHADORES *t, void *tarefa){
+   if(t == NULL) return false;
+
+   pthread_mutex_lock(&t->trava);
+   while(t->quantidade == t->capacidade && !t->encerrando) pthread_cond_wait(&t->tem_vaga, &t->trava);
+
+   if(t->encerrando){
+      pthread_mutex_unlock(&t->trava);
+      return false;
+   }
+
+   t->fila[(t->inicio + t->quantidade) % t->capacidade] = tarefa;
+   t->quantidade++;
+
+   pthread_cond_signal(&t->tem_tarefa);
+   pthread_mutex_unlock(&t->trava);
+   return true;
+}
+
+void trabalhadores_apagar(TRABALHADORES **t){
+   if(t == NULL || *t == NULL) return;
+
+   pthread_mutex_lock(&(*t)->trava);
+   (*t)->encerrando = true;
+   pthread_cond_broadcast(&(*t)->tem_tarefa);
+   pthread_cond_broadcast(&(*t)->tem_vaga);
+   pthread_mutex_unlock(&(*t)->trava);
+
+   for(int i = 0; i < (*t)->n_threads; i++) pthread_join((*t)->threads[i], NULL);
+
+   pthread_mutex_destroy(&(*t)->trava);
+   pthread_cond_destroy(&(*t)->tem_tarefa);
+   pthread_cond_destroy(&(*t)->tem_vaga);
+   free((*t)->fila);
+   free((*t)->threads);
+   free(*t); *t = NULL;
+}
+
+int trabalhadores_processadores(void){
+   long n = sysconf(_SC_NPROCESSORS_ONLN);
+   return n > 0 ? (int) n : 1;
+}
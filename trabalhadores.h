@@ -0,0 +1,27 @@
+#ifndef TRABALHADORES_H
+    #define TRABALHADORES_H
+
+    #include "caixeiro.h"
+
+    /*
+    Conjunto fixo de threads com uma fila limitada de tarefas. Cada thread
+    tem a sua CAIXEIRO_AREA, criada uma vez e reaproveitada em todas as
+    tarefas que ela executar, então os buffers da dp ficam "quentes".
+    */
+    typedef struct trabalhadores TRABALHADORES;
+
+    // Executa uma tarefa com a área da thread que a pegou.
+    typedef void (*TAREFA)(void *tarefa, CAIXEIRO_AREA *area);
+
+    TRABALHADORES *trabalhadores_criar(int threads, int capacidade, TAREFA executar);
+
+    // Enfileira uma tarefa; bloqueia enquanto a fila estiver cheia (contrapressão).
+    bool trabalhadores_enviar(TRABALHADORES *trabalhadores, void *tarefa);
+
+    // Espera a fila esvaziar, encerra as threads e libera tudo.
+    void trabalhadores_apagar(TRABALHADORES **trabalhadores);
+
+    // Número de processadores disponíveis (pelo menos 1).
+    int trabalhadores_processadores(void);
+
+#endif
@@ -0,0 +1,332 @@
+#include "tsplib.h"
+
+#include<stdlib.h>
+#include<string.h>
+#include<ctype.h>
+#include<math.h>
+
+#if defined(__SSE2__)
+#include<emmintrin.h>
+#endif
+
+#define TSPLIB_PI 3.141592
+#define TSPLIB_RAIO 6378.388
+#define TSPLIB_BLOCO 256
+
+typedef enum {
+   FORMATO_FULL_MATRIX,
+   FORMATO_UPPER_ROW,
+   FORMATO_LOWER_ROW,
+   FORMATO_UPPER_DIAG_ROW,
+   FORMATO_LOWER_DIAG_ROW
+} FORMATO;
+
+//tira espaços das pontas, no lugar
+static char *aparar(char *texto){
+   while(isspace((unsigned char) *texto)) texto++;
+
+   char *fim = texto + strlen(texto);
+   while(fim > texto && isspace((unsigned char) fim[-1])) *--fim = '\0';
+
+   return texto;
+}
+
+//GEO: graus.minutos -> radianos, truncando os graus como nas soluções publicadas da TSPLIB
+static double geo_radianos(double valor){
+   int graus = (int) valor;
+   double minutos = valor - graus;
+
+   return TSPLIB_PI * (graus + 5.0 * minutos / 3.0) / 180.0;
+}
+
+static bool ler_coordenadas(FILE *entrada, TSPLIB *tsplib){
+   tsplib->x = (double*) malloc(tsplib->N * sizeof(double));
+   tsplib->y = (double*) malloc(tsplib->N * sizeof(double));
+   if(tsplib->x == NULL || tsplib->y == NULL) return false;
+
+   //com N linhas e nenhum id repetido, todo id de 1 a N aparece exatamente uma vez
+   bool *visto = (bool*) calloc(tsplib->N, sizeof(bool));
+   if(visto == NULL) return false;
+
+   bool ok = true;
+   for(int i = 0; i < tsplib->N; i++){
+      int id;
+      double x, y;
+
+      if(fscanf(entrada, "%d %lf %lf", &id, &x, &y) != 3 || id < 1 || id > tsplib->N || visto[id-1]){
+         ok = false;
+         break;
+      }
+      visto[id-1] = true;
+
+      if(tsplib->tipo == TSPLIB_GEO){
+         x = geo_radianos(x);
+         y = geo_radianos(y);
+      }
+      tsplib->x[id-1] = x;
+      tsplib->y[id-1] = y;
+   }
+   free(visto);
+   return ok;
+}
+
+static bool ler_pesos(FILE *entrada, TSPLIB *tsplib, FORMATO formato){
+   int N = tsplib->N;
+
+   tsplib->matriz = (int*) calloc((size_t)N * N, sizeof(int));
+   if(tsplib->matriz == NULL) return false;
+
+   for(int i = 0; i < N; i++){
+      int de = 0, ate = N;
+
+      switch(formato){
+         case FORMATO_FULL_MATRIX: break;
+         case FORMATO_UPPER_ROW: de = i + 1; break;
+         case FORMATO_LOWER_ROW: ate = i; break;
+         case FORMATO_UPPER_DIAG_ROW: de = i; break;
+         case FORMATO_LOWER_DIAG_ROW: ate = i + 1; break;
+      }
+
+      for(int j = de; j < ate; j++){
+         int peso;
+
+         if(fscanf(entrada, "%d", &peso) != 1) return false;
+         tsplib->matriz[(size_t)i*N + j] = peso;
+         if(formato != FORMATO_FULL_MATRIX) tsplib->matriz[(size_t)j*N + i] = peso;
+      }
+   }
+   return true;
+}
+
+bool tsplib_ler(FILE *entrada, const char *lido, TSPLIB *tsplib){
+   char linha[1024];
+   FORMATO formato = FORMATO_FULL_MATRIX;
+   bool primeira = true, ok = false;
+
+   tsplib->N = 0;
+   tsplib->tipo = TSPLIB_EUC_2D;
+   tsplib->x = tsplib->y = NULL;
+   tsplib->matriz = NULL;
+
+   while(1){
+      size_t usado = 0;
+
+      //na primeira linha, o que quem chamou já leu vem antes do resto
+      if(primeira && lido != NULL){
+         usado = strlen(lido) < sizeof(linha) - 1 ? strlen(lido) : sizeof(linha) - 1;
+         memcpy(linha, lido, usado);
+         linha[usado] = '\0';
+      }
+      primeira = false;
+
+      if(usado == 0 || linha[usado-1] != '\n'){
+         if(fgets(linha + usado, sizeof(linha) - usado, entrada) == NULL && usado == 0) break;
+      }
+
+      char *texto = aparar(linha);
+      if(*texto == '\0') continue;
+
+      if(strncmp(texto, "EOF", 3) == 0) break;
+
+      if(strncmp(texto, "NODE_COORD_SECTION", 18) == 0){
+         if(tsplib->N <= 0 || tsplib->tipo == TSPLIB_EXPLICITO || !ler_coordenadas(entrada, tsplib)) goto erro;
+         ok = true;
+         continue;
+      }
+      if(strncmp(texto, "EDGE_WEIGHT_SECTION", 19) == 0){
+         if(tsplib->N <= 0 || tsplib->tipo != TSPLIB_EXPLICITO || !ler_pesos(entrada, tsplib, formato)) goto erro;
+         ok = true;
+         continue;
+      }
+      if(strncmp(texto, "DISPLAY_DATA_SECTION", 20) == 0){
+         for(int i = 0; i < tsplib->N; i++){
+            double a, b, c;
+            if(fscanf(entrada, "%lf %lf %lf", &a, &b, &c) != 3) goto erro;
+         }
+         continue;
+      }
+
+      //linha "CHAVE : VALOR"
+      char *dois_pontos = strchr(texto, ':');
+      if(dois_pontos == NULL) goto erro;
+      *dois_pontos = '\0';
+
+      char *chave = aparar(texto);
+      char *valor = aparar(dois_pontos + 1);
+
+      if(strcmp(chave, "DIMENSION") == 0){
+         tsplib->N = atoi(valor);
+      }
+      else if(strcmp(chave, "TYPE") == 0){
+         if(strcmp(valor, "TSP") != 0 && strcmp(valor, "ATSP") != 0) goto erro;
+      }
+      else if(strcmp(chave, "EDGE_WEIGHT_TYPE") == 0){
+         if(strcmp(valor, "EUC_2D") == 0) tsplib->tipo = TSPLIB_EUC_2D;
+         else if(strcmp(valor, "CEIL_2D") == 0) tsplib->tipo = TSPLIB_CEIL_2D;
+         else if(strcmp(valor, "ATT") == 0) tsplib->tipo = TSPLIB_ATT;
+         else if(strcmp(valor, "GEO") == 0) tsplib->tipo = TSPLIB_GEO;
+         else if(strcmp(valor, "EXPLICIT") == 0) tsplib->tipo = TSPLIB_EXPLICITO;
+         else goto erro;
+      }
+      else if(strcmp(chave, "EDGE_WEIGHT_FORMAT") == 0){
+         if(strcmp(valor, "FULL_MATRIX") == 0) formato = FORMATO_FULL_MATRIX;
+         else if(strcmp(valor, "UPPER_ROW") == 0) formato = FORMATO_UPPER_ROW;
+         else if(strcmp(valor, "LOWER_ROW") == 0) formato = FORMATO_LOWER_ROW;
+         else if(strcmp(valor, "UPPER_DIAG_ROW") == 0) formato = FORMATO_UPPER_DIAG_ROW;
+         else if(strcmp(valor, "LOWER_DIAG_ROW") == 0) formato = FORMATO_LOWER_DIAG_ROW;
+         else if(strcmp(valor, "FUNCTION") != 0) goto erro; //FUNCTION: pesos vêm das coordenadas
+      }
+      //NAME, COMMENT, NODE_COORD_TYPE, DISPLAY_DATA_TYPE...: só informativos
+   }
+
+   if(ok) return true;
+
+erro:
+   tsplib_liberar(tsplib);
+   return false;
+}
+
+void tsplib_liberar(TSPLIB *tsplib){
+   if(tsplib == NULL) return;
+
+   free(tsplib->x);
+   free(tsplib->y);
+   free(tsplib->matriz);
+   tsplib->x = tsplib->y = NULL;
+   tsplib->matriz = NULL;
+   tsplib->N = 0;
+}
+
+int tsplib_distancia(const TSPLIB *tsplib, int i, int j){
+   int d;
+
+   tsplib_linha(tsplib, i, j, j + 1, &d);
+   return d;
+}
+
+/*
+Distâncias de i até [inicio, fim). EUC_2D e ATT usam SSE2 (duas por vez)
+quando disponível: raiz e arredondamento em double, exatamente as mesmas
+operações IEEE da versão escalar, que trata as sobras e os outros tipos.
+*/
+void tsplib_linha(const TSPLIB *tsplib, int i, int inicio, int fim, int *saida){
+   const double *x = tsplib->x, *y = tsplib->y;
+   int j = inicio;
+
+   if(tsplib->tipo == TSPLIB_EXPLICITO){
+      memcpy(saida, &tsplib->matriz[(size_t)i*tsplib->N + inicio], (fim - inicio) * sizeof(int));
+      return;
+   }
+
+#if defined(__SSE2__)
+   if(tsplib->tipo == TSPLIB_EUC_2D || tsplib->tipo == TSPLIB_ATT){
+      __m128d xi = _mm_set1_pd(x[i]), yi = _mm_set1_pd(y[i]);
+      __m128d meio = _mm_set1_pd(0.5), um = _mm_set1_pd(1.0), dez = _mm_set1_pd(10.0);
+      bool att = tsplib->tipo == TSPLIB_ATT;
+
+      for(; j + 2 <= fim; j += 2){
+         __m128d dx = _mm_sub_pd(xi, _mm_loadu_pd(&x[j]));
+         __m128d dy = _mm_sub_pd(yi, _mm_loadu_pd(&y[j]));
+         __m128d quadrado = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+         __m128i d;
+
+         if(!att){
+            //nint(sqrt(dx^2 + dy^2))
+            d = _mm_cvttpd_epi32(_mm_add_pd(_mm_sqrt_pd(quadrado), meio));
+         }
+         else{
+            //r = sqrt((dx^2 + dy^2) / 10); t = nint(r); t < r ? t + 1 : t
+            __m128d r = _mm_sqrt_pd(_mm_div_pd(quadrado, dez));
+            __m128d t = _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_add_pd(r, meio)));
+            t = _mm_add_pd(t, _mm_and_pd(_mm_cmplt_pd(t, r), um));
+            d = _mm_cvttpd_epi32(t);
+         }
+         _mm_storel_epi64((__m128i*) &saida[j - inicio], d);
+      }
+   }
+#endif
+
+   for(; j < fim; j++){
+      double dx = x[i] - x[j], dy = y[i] - y[j];
+      int d = 0;
+
+      switch(tsplib->tipo){
+         case TSPLIB_EUC_2D:
+            d = (int)(sqrt(dx*dx + dy*dy) + 0.5);
+            break;
+         case TSPLIB_CEIL_2D:
+            d = (int) ceil(sqrt(dx*dx + dy*dy));
+            break;
+         case TSPLIB_ATT: {
+            double r = sqrt((dx*dx + dy*dy) / 10.0);
+            int t = (int)(r + 0.5);
+            d = (t < r) ? t + 1 : t;
+            break;
+         }
+         case TSPLIB_GEO: {
+            //x = latitude, y = longitude, já em radianos
+            double q1 = cos(y[i] - y[j]);
+            double q2 = cos(x[i] - x[j]);
+            double q3 = cos(x[i] + x[j]);
+            d = (int)(TSPLIB_RAIO * acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+            break;
+         }
+         case TSPLIB_EXPLICITO:
+            break;
+      }
+      saida[j - inicio] = d;
+   }
+
+   //a diagonal é zero em todos os tipos (GEO daria 1)
+   if(i >= inicio && i < fim) saida[i - inicio] = 0;
+}
+
+void tsplib_matriz(const TSPLIB *tsplib, int *peso){
+   int N = tsplib->N;
+
+   for(int i = 0; i < N; i++){
+      for(int j = 0; j < N; j += TSPLIB_BLOCO){
+         int fim = j + TSPLIB_BLOCO < N ? j + TSPLIB_BLOCO : N;
+         tsplib_linha(tsplib, i, j, fim, &peso[(size_t)i*N + j]);
+      }
+   }
+}
+
+/*
+Vizinho mais próximo a partir da cidade 0, em O(N^2) sem matriz: a cada
+passo calcula a linha da cidade atual em blocos e fica com a mais perto
+ainda não visitada. Serve de rota inicial para instâncias grandes.
+*/
+bool tsplib_rota_gulosa(const TSPLIB *tsplib, int *rota){
+   int N = tsplib->N;
+   int bloco[TSPLIB_BLOCO];
+   bool *visitado = (bool*) calloc(N, sizeof(bool));
+
+   if(visitado == NULL) return false;
+
+   rota[0] = 0;
+   visitado[0] = true;
+
+   for(int pos = 1; pos < N; pos++){
+      int atual = rota[pos-1], proximo = -1, menor = 0;
+
+      for(int j = 0; j < N; j += TSPLIB_BLOCO){
+         int fim = j + TSPLIB_BLOCO < N ? j + TSPLIB_BLOCO : N;
+
+         tsplib_linha(tsplib, atual, j, fim, bloco);
+         for(int c = j; c < fim; c++){
+            if(visitado[c]) continue;
+            if(proximo == -1 || bloco[c - j] < menor){
+               proximo = c;
+               menor = bloco[c - j];
+            }
+         }
+      }
+
+      rota[pos] = proximo;
+      visitado[proximo] = true;
+   }
+
+   free(visitado);
+   return true;
+}
@@ -0,0 +1,50 @@
+#ifndef TSPLIB_H
+    #define TSPLIB_H
+
+    #include<stdio.h>
+    #include<stdbool.h>
+
+    typedef enum {
+        TSPLIB_EUC_2D,
+        TSPLIB_CEIL_2D,
+        TSPLIB_ATT,
+        TSPLIB_GEO,
+        TSPLIB_EXPLICITO
+    } TSPLIB_TIPO;
+
+    /*
+    Instância no formato TSPLIB. Nas de coordenadas só x[] e y[] ficam em
+    memória (GEO já convertido para radianos) e as distâncias são calculadas
+    quando pedidas, com o arredondamento da TSPLIB; nas EXPLICIT a matriz
+    N*N lida do arquivo fica em `matriz`.
+    */
+    typedef struct {
+        int N;
+        TSPLIB_TIPO tipo;
+        double *x;
+        double *y;
+        int *matriz;
+    } TSPLIB;
+
+    /*
+    Lê uma instância TSP/ATSP até a linha EOF (ou o fim do arquivo).
+    `lido` são bytes do começo da primeira linha que quem chama já consumiu
+    da entrada (NULL se nenhum). Aceita EDGE_WEIGHT_TYPE EUC_2D, CEIL_2D,
+    ATT, GEO e EXPLICIT (FULL_MATRIX, UPPER_ROW, LOWER_ROW, UPPER_DIAG_ROW,
+    LOWER_DIAG_ROW).
+    */
+    bool tsplib_ler(FILE *entrada, const char *lido, TSPLIB *tsplib);
+    void tsplib_liberar(TSPLIB *tsplib);
+
+    int tsplib_distancia(const TSPLIB *tsplib, int i, int j);
+
+    // saida[k] = distância de i até inicio + k, para k em [0, fim - inicio).
+    void tsplib_linha(const TSPLIB *tsplib, int i, int inicio, int fim, int *saida);
+
+    // Preenche peso[i*N + j] com todas as distâncias, linha por linha em blocos.
+    void tsplib_matriz(const TSPLIB *tsplib, int *peso);
+
+    // rota[0..N-1]: vizinho mais próximo a partir da cidade 0, sem montar a matriz.
+    bool tsplib_rota_gulosa(const TSPLIB *tsplib, int *rota);
+
+#endif
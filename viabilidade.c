@@ -0,0 +1,144 @@
+#include "viabilidade.h"
+
+#define BIT(v) ((uint64_t)1 << (v))
+
+static int contar_bits(uint64_t x){
+#if defined(__GNUC__)
+   return __builtin_popcountll(x);
+#else
+   int n = 0;
+   for(; x != 0; x &= x - 1) n++;
+   return n;
+#endif
+}
+
+static int menor_bit(uint64_t x){
+#if defined(__GNUC__)
+   return __builtin_ctzll(x);
+#else
+   int i = 0;
+   while((x & 1) == 0){ x >>= 1; i++; }
+   return i;
+#endif
+}
+
+/*Busca em largura por bits: cada passo junta os vizinhos de toda a fronteira*/
+static bool conexo(const uint64_t *vizinhos, int N){
+   uint64_t visitados = BIT(0), fronteira = BIT(0);
+
+   while(fronteira != 0){
+      uint64_t proxima = 0;
+      for(uint64_t f = fronteira; f != 0; f &= f - 1) proxima |= vizinhos[menor_bit(f)];
+      fronteira = proxima & ~visitados;
+      visitados |= fronteira;
+   }
+   return visitados == (N == 64 ? ~(uint64_t)0 : BIT(N) - 1);
+}
+
+/*Tarjan: `v` é articulação se algum filho na dfs não alcança acima de `v`*/
+static bool tem_articulacao_dfs(const uint64_t *vizinhos, int v, int pai, int *tempo, int *entrada, int *baixo){
+   int filhos = 0;
+
+   entrada[v] = baixo[v] = ++(*tempo);
+
+   for(uint64_t r = vizinhos[v]; r != 0; r &= r - 1){
+      int u = menor_bit(r);
+
+      if(entrada[u] == 0){
+         filhos++;
+         if(tem_articulacao_dfs(vizinhos, u, v, tempo, entrada, baixo)) return true;
+         if(baixo[u] < baixo[v]) baixo[v] = baixo[u];
+         if(pai != -1 && baixo[u] >= entrada[v]) return true;
+      }
+      else if(u != pai && entrada[u] < baixo[v]){
+         baixo[v] = entrada[u];
+      }
+   }
+
+   return pai == -1 && filhos > 1;
+}
+
+static bool tem_articulacao(const uint64_t *vizinhos, int N){
+   int entrada[64] = {0}, baixo[64], tempo = 0;
+
+   (void) N;
+   return tem_articulacao_dfs(vizinhos, 0, -1, &tempo, entrada, baixo);
+}
+
+/*Union-find das arestas forçadas, para achar subciclos*/
+static int raiz(int *pai, int v){
+   while(pai[v] != v){
+      pai[v] = pai[pai[v]];
+      v = pai[v];
+   }
+   return v;
+}
+
+bool viabilidade_reduzir(uint64_t *vizinhos, int N){
+   uint64_t forcadas[64] = {0};
+   int pilha[64 * 2], topo = 0;
+   int componente[64], tamanho[64];
+   bool na_pilha[64] = {false};
+
+   if(N < 3) return true;
+
+   for(int v = 0; v < N; v++){
+      vizinhos[v] &= ~BIT(v);
+      componente[v] = v;
+      tamanho[v] = 1;
+   }
+
+   for(int v = 0; v < N; v++){
+      if(contar_bits(vizinhos[v]) < 2) return false;
+      if(contar_bits(vizinhos[v]) == 2){
+         pilha[topo++] = v;
+         na_pilha[v] = true;
+      }
+   }
+
+   //propago: grau 2 força as duas arestas; duas forçadas apagam as demais
+   while(topo > 0){
+      int v = pilha[--topo];
+      na_pilha[v] = false;
+
+      uint64_t novas = vizinhos[v] & ~forcadas[v];
+      if(contar_bits(vizinhos[v]) != 2 || novas == 0) continue;
+
+      for(uint64_t r = novas; r != 0; r &= r - 1){
+         int u = menor_bit(r);
+         int a = raiz(componente, v), b = raiz(componente, u);
+
+         //a aresta v-u fecha um ciclo: só vale se for o ciclo com todos os vértices
+         if(a == b && tamanho[a] < N) return false;
+         if(a != b){
+            componente[a] = b;
+            tamanho[b] += tamanho[a];
+         }
+
+         forcadas[v] |= BIT(u);
+         forcadas[u] |= BIT(v);
+
+         int n_forcadas = contar_bits(forcadas[u]);
+         if(n_forcadas > 2) return false;
+         if(n_forcadas < 2) continue;
+
+         //u já tem as suas duas arestas da rota: as outras saem do grafo
+         for(uint64_t x = vizinhos[u] & ~forcadas[u]; x != 0; x &= x - 1){
+            int w = menor_bit(x);
+
+            vizinhos[w] &= ~BIT(u);
+            if(contar_bits(vizinhos[w]) < 2) return false;
+            if(contar_bits(vizinhos[w]) == 2 && !na_pilha[w]){
+               pilha[topo++] = w;
+               na_pilha[w] = true;
+            }
+         }
+         vizinhos[u] = forcadas[u];
+      }
+   }
+
+   if(!conexo(vizinhos, N)) return false;
+   if(tem_articulacao(vizinhos, N)) return false;
+
+   return true;
+}
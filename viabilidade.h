@@ -0,0 +1,25 @@
+#ifndef VIABILIDADE_H
+    #define VIABILIDADE_H
+
+    #include<stdint.h>
+    #include<stdbool.h>
+
+    /*
+    Verificações baratas, antes da dp exponencial, de que pode existir um
+    ciclo hamiltoniano. O grafo é dado por vizinhos[v]: bit u ligado se há
+    aresta entre v e u em qualquer sentido (sem laços), com N <= 64.
+
+    Rejeita em O(N + E): vértice com grau < 2, grafo desconexo, ponto de
+    articulação (todo grafo com ciclo hamiltoniano é 2-conexo) e arestas
+    forçadas inconsistentes. Um vértice de grau 2 força as suas duas arestas
+    na rota; um vértice com duas arestas forçadas perde todas as outras, o
+    que pode forçar mais arestas, até estabilizar. Três arestas forçadas no
+    mesmo vértice, ou forçadas fechando um ciclo com menos de N vértices,
+    tornam a instância impossível.
+
+    Retorna false se não há rota. Caso contrário deixa em vizinhos[] o grafo
+    já sem as arestas que nenhuma rota pode usar. Com N < 3 não verifica nada.
+    */
+    bool viabilidade_reduzir(uint64_t *vizinhos, int N);
+
+#endif